@@ -0,0 +1,752 @@
+// Microbenchmarks for MotionDetector::process and the frame/result queues.
+//
+//   motion_bench [--quick] [--filter SUBSTR] [--out results.json]
+//                [--baseline baseline.json] [--tolerance 0.10]
+//
+// Results are written as JSON, one result object per line. With
+// --baseline, each result is compared by name against the stored run and
+// anything slower than tolerance is flagged; the exit code is 2 if any
+// regression was found. accuracy/* results also carry recall and precision
+// against the ground truth of a synthetic:// source. strips/* runs check
+// that strip-parallel events match strips = 1 and exit with 3 if not.
+// checkpoint/* runs check that a detector restored from a checkpoint
+// reports the same events as the one that saved it and exit with 4 if not.
+// allocations/* runs report heap allocations per steady-state frame.
+// Before anything else the SIMD detection kernels are checked against the
+// scalar one on random input (exit code 5 if they differ), and the fused
+// kernel against the OpenCV path within its stated tolerance (exit code 6).
+#include "core/background_checkpoint.hpp"
+#include "core/motion_detector.hpp"
+#include "core/motion_kernels.hpp"
+#include "core/synthetic_source.hpp"
+#include "core/worker_pool.hpp"
+#include "models/detection_result.hpp"
+#include "queues/broadcast_channel.hpp"
+#include "queues/frame_queue.hpp"
+#include "queues/thread_queue.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Every heap allocation in the process, counted for allocations/* runs.
+// OpenCV allocates Mat data with malloc, not operator new, so malloc is
+// interposed (glibc only); operator new ends up here too.
+std::atomic<uint64_t> g_heap_allocations{0};
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) noexcept {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+void* calloc(size_t count, size_t size) noexcept {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+void* realloc(void* ptr, size_t size) noexcept {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+void* memalign(size_t alignment, size_t size) noexcept {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    return memalign(alignment, size);
+}
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+    void* ptr = memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+}  // extern "C"
+constexpr bool kCountsAllocations = true;
+#else
+constexpr bool kCountsAllocations = false;
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+struct BenchOptions {
+    bool quick = false;
+    std::string filter;
+    std::string out = "motion_bench.json";
+    std::string baseline;
+    double tolerance = 0.10;
+};
+
+struct Result {
+    std::string name;
+    double ns_per_op = 0;   // mean
+    double p50_ns = 0;
+    double p99_ns = 0;
+    double ops_per_sec = 0;
+    uint64_t ops = 0;
+    double recall = -1;     // accuracy runs only
+    double precision = -1;
+    double allocations = -1;  // heap allocations per op, allocations runs only
+};
+
+Result summarize(const std::string& name, std::vector<int64_t>& samples, double seconds) {
+    Result r;
+    r.name = name;
+    r.ops = samples.size();
+    if (samples.empty()) return r;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (int64_t s : samples) sum += static_cast<double>(s);
+    r.ns_per_op = sum / samples.size();
+    r.p50_ns = static_cast<double>(samples[samples.size() / 2]);
+    r.p99_ns = static_cast<double>(samples[std::min(samples.size() - 1, samples.size() * 99 / 100)]);
+    r.ops_per_sec = seconds > 0 ? samples.size() / seconds : 0;
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Detector
+
+/**
+ * A few frames of static noise texture with moving filled rectangles
+ * covering `density` of the frame, plus low-amplitude per-frame sensor
+ * noise. Frames are cycled, so blobs jump between a handful of positions.
+ */
+std::vector<cv::Mat> syntheticFrames(cv::Size size, double density, int count) {
+    cv::RNG rng(12345);
+    cv::Mat texture(size, CV_8UC3);
+    rng.fill(texture, cv::RNG::UNIFORM, 60, 190);
+    cv::GaussianBlur(texture, texture, cv::Size(7, 7), 0);
+
+    const int blobs = 4;
+    int side = static_cast<int>(std::sqrt(density * size.area() / blobs));
+    std::vector<cv::Mat> frames;
+    for (int i = 0; i < count; ++i) {
+        cv::Mat frame = texture.clone();
+        cv::Mat noise(size, CV_8UC3);
+        rng.fill(noise, cv::RNG::NORMAL, 0, 2);
+        frame += noise;
+        for (int b = 0; side > 0 && b < blobs; ++b) {
+            int x = (size.width - side) * ((b * 37 + i * 11) % 100) / 100;
+            int y = (size.height - side) * ((b * 53 + i * 7) % 100) / 100;
+            cv::rectangle(frame, cv::Rect(x, y, side, side),
+                          cv::Scalar(20 + 50 * b, 240 - 40 * b, 128), cv::FILLED);
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+MotionDetector::Config detectorConfig(float roi_ratio, int blur, bool fixed_point) {
+    MotionDetector::Config cfg;
+    cfg.roi.center_x = 0.5f;
+    cfg.roi.center_y = 0.5f;
+    cfg.roi.width_ratio = roi_ratio;
+    cfg.roi.height_ratio = roi_ratio;
+    cfg.blur_kernel = blur;
+    cfg.fixed_point = fixed_point;
+    return cfg;
+}
+
+Result benchDetector(const std::string& name, const std::vector<cv::Mat>& frames,
+                     const MotionDetector::Config& cfg, WorkerPool* pool, double min_seconds) {
+    MotionDetector detector(cfg);
+    detector.setWorkerPool(pool);
+
+    uint64_t id = 0;
+    // Warm up: background init plus steady-state buffers
+    for (int i = 0; i < 10; ++i, ++id) {
+        detector.process(frames[id % frames.size()], id, static_cast<int64_t>(id));
+    }
+
+    std::vector<int64_t> samples;
+    auto start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < min_seconds || samples.size() < 20) {
+        int64_t t0 = nowNs();
+        detector.process(frames[id % frames.size()], id, static_cast<int64_t>(id));
+        samples.push_back(nowNs() - t0);
+        ++id;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return summarize(name, samples, elapsed);
+}
+
+/**
+ * Heap allocations per frame once warmed up: process() plus filling and
+ * publishing a DetectionResult the way MotionConsumer does, with a
+ * subscriber reading every result.
+ */
+Result benchAllocations(const std::string& name, const std::vector<cv::Mat>& frames,
+                        const MotionDetector::Config& cfg, int count) {
+    MotionDetector detector(cfg);
+    BroadcastChannel<DetectionResult> results;
+    auto subscriber = results.subscribe();
+    auto step = [&](uint64_t id) {
+        detector.process(frames[id % frames.size()], id, static_cast<int64_t>(id));
+        DetectionResult& result = results.claim();
+        result.frame = cv::Mat();
+        result.events = detector.events();
+        result.boxes = detector.boxes();
+        results.publish();
+        subscriber->tryNext();
+    };
+
+    // Warm up until every result slot has been recycled once
+    uint64_t id = 0;
+    for (; id < 2 * frames.size() + 2 * results.capacity(); ++id) step(id);
+
+    std::vector<int64_t> samples;
+    samples.reserve(count);
+    const uint64_t before = g_heap_allocations.load(std::memory_order_relaxed);
+    auto start = Clock::now();
+    for (int i = 0; i < count; ++i, ++id) {
+        int64_t t0 = nowNs();
+        step(id);
+        samples.push_back(nowNs() - t0);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    uint64_t allocations = g_heap_allocations.load(std::memory_order_relaxed) - before;
+    Result r = summarize(name, samples, seconds);
+    r.allocations = kCountsAllocations ? static_cast<double>(allocations) / count : -1;
+    return r;
+}
+
+/**
+ * Checks the fused kernel against the OpenCV path it replaces (convertTo,
+ * absdiff, threshold, accumulateWeighted) within the bounds stated in
+ * motion_kernels.hpp: from the same background the mask is identical and
+ * the update differs by at most 1e-4. Backgrounds are random values near
+ * the frame, a quarter of them exactly half-way so rounding is exercised.
+ */
+bool fusedMatchesOpenCV(const std::vector<cv::Mat>& frames, double& max_delta) {
+    const int threshold = 25;
+    const double alpha = 0.01;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> offset(-2 * threshold, 2 * threshold);
+    cv::Mat cur, cur_f, bg8, diff, mask_ref, mask, bg_ref, bg, differs;
+    max_delta = 0.0;
+    for (const cv::Mat& frame : frames) {
+        cv::cvtColor(frame, cur, cv::COLOR_BGR2GRAY);
+        bg_ref.create(cur.size(), CV_32FC1);
+        for (int y = 0; y < cur.rows; ++y) {
+            const uint8_t* c = cur.ptr<uint8_t>(y);
+            float* b = bg_ref.ptr<float>(y);
+            for (int x = 0; x < cur.cols; ++x) {
+                int v = std::min(255, std::max(0, c[x] + offset(rng)));
+                b[x] = static_cast<float>(v) + ((x & 3) == 0 ? 0.5f : (rng() & 0xff) / 256.0f);
+            }
+        }
+        bg_ref.copyTo(bg);
+
+        bg_ref.convertTo(bg8, CV_8U);
+        cv::absdiff(cur, bg8, diff);
+        cv::threshold(diff, mask_ref, threshold, 255, cv::THRESH_BINARY);
+        cur.convertTo(cur_f, CV_32F);
+        cv::accumulateWeighted(cur_f, bg_ref, alpha);
+
+        fusedDiffThresholdUpdate(cur, bg, mask, threshold, alpha);
+        cv::compare(mask, mask_ref, differs, cv::CMP_NE);
+        if (cv::countNonZero(differs) != 0) return false;
+        max_delta = std::max(max_delta, cv::norm(bg, bg_ref, cv::NORM_INF));
+    }
+    return max_delta <= 1e-4;
+}
+
+/** Runs cfg and the same config with strips = 1 side by side; true if all events match */
+bool stripsMatch(const std::vector<cv::Mat>& frames, const MotionDetector::Config& cfg,
+                 WorkerPool& pool) {
+    MotionDetector::Config sequential_cfg = cfg;
+    sequential_cfg.strips = 1;
+    MotionDetector sequential(sequential_cfg);
+    MotionDetector parallel(cfg);
+    parallel.setWorkerPool(&pool);
+    for (uint64_t id = 0; id < 3 * frames.size(); ++id) {
+        const cv::Mat& frame = frames[id % frames.size()];
+        MotionEvent a = sequential.process(frame, id, static_cast<int64_t>(id));
+        MotionEvent b = parallel.process(frame, id, static_cast<int64_t>(id));
+        if (a.motion_score != b.motion_score || a.contour_count != b.contour_count ||
+            a.largest_bbox != b.largest_bbox || sequential.boxes() != parallel.boxes()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameEvents(MotionDetector& a, MotionDetector& b, const cv::Mat& frame, uint64_t id) {
+    MotionEvent ea = a.process(frame, id, static_cast<int64_t>(id));
+    MotionEvent eb = b.process(frame, id, static_cast<int64_t>(id));
+    return ea.motion_score == eb.motion_score && ea.contour_count == eb.contour_count &&
+           ea.largest_bbox == eb.largest_bbox && a.boxes() == b.boxes();
+}
+
+/**
+ * Times saving (save) or loading a checkpoint of a warmed-up detector's
+ * models. Afterwards a fresh detector is restored from the file; match is
+ * false unless it reports the same events as the original from its first
+ * frame on.
+ */
+Result benchCheckpoint(const std::string& name, const std::vector<cv::Mat>& frames,
+                       const MotionDetector::Config& cfg, bool save, double min_seconds,
+                       bool& match) {
+    const std::string path = "motion_bench.mdbg";
+    MotionDetector original(cfg);
+    uint64_t id = 0;
+    for (; id < 2 * frames.size(); ++id) {
+        original.process(frames[id % frames.size()], id, static_cast<int64_t>(id));
+    }
+    BackgroundSnapshot snapshot;
+    original.snapshotBackground(snapshot);
+    saveBackgroundCheckpoint(path, snapshot);
+
+    std::vector<int64_t> samples;
+    auto start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < min_seconds || samples.size() < 5) {
+        int64_t t0 = nowNs();
+        if (save) {
+            original.snapshotBackground(snapshot);
+            saveBackgroundCheckpoint(path, snapshot);
+        } else {
+            BackgroundSnapshot loaded;
+            loadBackgroundCheckpoint(path, loaded);
+        }
+        samples.push_back(nowNs() - t0);
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    BackgroundSnapshot loaded;
+    MotionDetector restored(cfg);
+    match = loadBackgroundCheckpoint(path, loaded);
+    restored.restoreBackground(std::move(loaded));
+    for (size_t i = 0; match && i < frames.size(); ++i, ++id) {
+        match = sameEvents(original, restored, frames[id % frames.size()], id);
+    }
+    match = match && restored.restoredModels() == snapshot.models.size();
+    std::remove(path.c_str());
+    return summarize(name, samples, elapsed);
+}
+
+/**
+ * Runs the detector over a synthetic:// source and scores its boxes
+ * against ground truth: a blob counts as found if some box covers at
+ * least half of it, and a box is a true positive if it touches any blob
+ * (boxes also span the short trail a moving blob leaves in the background).
+ */
+Result benchAccuracy(const std::string& name, const std::string& uri, int frames) {
+    SyntheticSource::Spec spec;
+    SyntheticSource::parse(uri, spec);
+    SyntheticSource source(spec);
+
+    MotionDetector::Config cfg;
+    cfg.roi.width_ratio = 1.0f;
+    cfg.roi.height_ratio = 1.0f;
+    MotionDetector detector(cfg);
+
+    cv::Mat frame;
+    std::vector<int64_t> samples;
+    uint64_t blobs = 0, found = 0, boxes = 0, true_boxes = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < frames; ++i) {
+        uint64_t index = static_cast<uint64_t>(i);
+        source.render(index, frame);
+        int64_t t0 = nowNs();
+        detector.process(frame, index, static_cast<int64_t>(index));
+        samples.push_back(nowNs() - t0);
+        if (i < 10) continue;  // background still settling
+
+        auto truth = source.groundTruth(index);
+        for (const cv::Rect& gt : truth) {
+            for (const cv::Rect& box : detector.boxes()) {
+                if ((gt & box).area() * 2 >= gt.area()) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+        for (const cv::Rect& box : detector.boxes()) {
+            for (const cv::Rect& gt : truth) {
+                if ((gt & box).area() > 0) {
+                    ++true_boxes;
+                    break;
+                }
+            }
+        }
+        blobs += truth.size();
+        boxes += detector.boxes().size();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    Result r = summarize(name, samples, seconds);
+    r.recall = blobs ? static_cast<double>(found) / blobs : 1.0;
+    r.precision = boxes ? static_cast<double>(true_boxes) / boxes : 1.0;
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Queues
+
+/**
+ * Producers push `per_producer` frames each into a BLOCK queue while
+ * consumers pop; per-item latency is push-to-pop.
+ */
+Result benchFrameQueue(const std::string& name, bool lock_free, int producers,
+                       int consumers, int per_producer) {
+    FrameQueue::Options opts;
+    opts.max_size = 64;
+    opts.policy = OverflowPolicy::BLOCK;
+    opts.lock_free = lock_free;
+    auto queue = FrameQueue::create(opts);
+    cv::Mat payload(1, 1, CV_8UC3);
+
+    const uint64_t total = static_cast<uint64_t>(producers) * per_producer;
+    std::atomic<uint64_t> popped{0};
+    std::vector<std::vector<int64_t>> latencies(consumers);
+    std::vector<std::thread> threads;
+
+    auto start = Clock::now();
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c] {
+            latencies[c].reserve(total / consumers + 1);
+            TimestampedFrame tf;
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (!queue->pop(tf, 10)) continue;
+                latencies[c].push_back(nowNs() - tf.capture_ns);
+                popped.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < per_producer; ++i) {
+                queue->push(TimestampedFrame{payload, 0, static_cast<uint64_t>(p), nowNs()});
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    queue->shutdown();
+
+    std::vector<int64_t> all;
+    for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    Result r = summarize(name, all, seconds);
+    // Throughput is what matters for contention; report wall time per item
+    r.ns_per_op = seconds * 1e9 / std::max<uint64_t>(total, 1);
+    return r;
+}
+
+Result benchThreadQueue(const std::string& name, int producers, int consumers,
+                        int per_producer) {
+    ThreadQueue<int64_t> queue;
+    const uint64_t total = static_cast<uint64_t>(producers) * per_producer;
+    std::atomic<uint64_t> popped{0};
+    std::vector<std::vector<int64_t>> latencies(consumers);
+    std::vector<std::thread> threads;
+
+    auto start = Clock::now();
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c] {
+            latencies[c].reserve(total / consumers + 1);
+            while (popped.load(std::memory_order_relaxed) < total) {
+                auto item = queue.tryPop();
+                if (!item) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                latencies[c].push_back(nowNs() - *item);
+                popped.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < per_producer; ++i) queue.push(nowNs());
+        });
+    }
+    for (auto& t : threads) t.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<int64_t> all;
+    for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    Result r = summarize(name, all, seconds);
+    r.ns_per_op = seconds * 1e9 / std::max<uint64_t>(total, 1);
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Output and baseline comparison
+
+std::string toJsonLine(const Result& r) {
+    char buf[512];
+    std::snprintf(buf, sizeof(buf),
+        "{\"name\": \"%s\", \"ns_per_op\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f, "
+        "\"ops_per_sec\": %.1f, \"ops\": %llu}",
+        r.name.c_str(), r.ns_per_op, r.p50_ns, r.p99_ns, r.ops_per_sec,
+        static_cast<unsigned long long>(r.ops));
+    std::string line = buf;
+    if (r.recall >= 0) {
+        std::snprintf(buf, sizeof(buf), ", \"recall\": %.4f, \"precision\": %.4f}",
+                      r.recall, r.precision);
+        line.replace(line.size() - 1, 1, buf);
+    }
+    if (r.allocations >= 0) {
+        std::snprintf(buf, sizeof(buf), ", \"allocations\": %.2f}", r.allocations);
+        line.replace(line.size() - 1, 1, buf);
+    }
+    return line;
+}
+
+bool writeJson(const std::string& path, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "{\n  \"version\": 1,\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        out << "    " << toJsonLine(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+// Reads name -> ns_per_op from a file written by writeJson (one result per line)
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    std::string line;
+    const std::string name_key = "\"name\": \"";
+    const std::string ns_key = "\"ns_per_op\": ";
+    while (std::getline(in, line)) {
+        size_t n = line.find(name_key);
+        size_t v = line.find(ns_key);
+        if (n == std::string::npos || v == std::string::npos) continue;
+        n += name_key.size();
+        size_t end = line.find('"', n);
+        if (end == std::string::npos) continue;
+        baseline[line.substr(n, end - n)] = std::strtod(line.c_str() + v + ns_key.size(), nullptr);
+    }
+    return baseline;
+}
+
+int compare(const std::vector<Result>& results, const std::map<std::string, double>& baseline,
+            double tolerance) {
+    int regressions = 0;
+    std::printf("\n%-52s %12s %12s %8s\n", "benchmark", "baseline ns", "current ns", "delta");
+    for (const auto& r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0) {
+            std::printf("%-52s %12s %12.0f %8s\n", r.name.c_str(), "-", r.ns_per_op, "new");
+            continue;
+        }
+        double delta = r.ns_per_op / it->second - 1.0;
+        const char* flag = "";
+        if (delta > tolerance) {
+            flag = "  REGRESSION";
+            ++regressions;
+        } else if (delta < -tolerance) {
+            flag = "  improved";
+        }
+        std::printf("%-52s %12.0f %12.0f %+7.1f%%%s\n", r.name.c_str(), it->second,
+                    r.ns_per_op, delta * 100.0, flag);
+    }
+    std::printf("\n%d regression(s) beyond %.0f%%\n", regressions, tolerance * 100.0);
+    return regressions;
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quick") opts.quick = true;
+        else if (arg == "--filter" && i + 1 < argc) opts.filter = argv[++i];
+        else if (arg == "--out" && i + 1 < argc) opts.out = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc) opts.baseline = argv[++i];
+        else if (arg == "--tolerance" && i + 1 < argc) opts.tolerance = std::stod(argv[++i]);
+        else return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    if (!parseArgs(argc, argv, opts)) {
+        std::cerr << "Usage: " << argv[0] << " [--quick] [--filter SUBSTR] [--out FILE]"
+                  << " [--baseline FILE] [--tolerance FRACTION]\n";
+        return 1;
+    }
+    auto selected = [&](const std::string& name) {
+        return opts.filter.empty() || name.find(opts.filter) != std::string::npos;
+    };
+
+    if (const char* path = fusedKernelMismatch()) {
+        std::cerr << "Fused kernel: " << path << " output differs from scalar" << std::endl;
+        return 5;
+    }
+    double max_delta = 0.0;
+    if (!fusedMatchesOpenCV(syntheticFrames(cv::Size(1280, 720), 0.05, 4), max_delta)) {
+        std::cerr << "Fused kernel (" << fusedKernelPath() << ") outside the stated tolerance"
+                  << " of the OpenCV path: max background delta " << max_delta << std::endl;
+        return 6;
+    }
+
+    std::vector<Result> results;
+    auto report = [&](const Result& r) {
+        std::printf("%-52s %10.0f ns/op  p50 %10.0f  p99 %10.0f",
+                    r.name.c_str(), r.ns_per_op, r.p50_ns, r.p99_ns);
+        if (r.recall >= 0) std::printf("  recall %.3f  precision %.3f", r.recall, r.precision);
+        if (r.allocations >= 0) std::printf("  allocations %.2f", r.allocations);
+        std::printf("\n");
+        std::fflush(stdout);
+        results.push_back(r);
+    };
+
+    const double min_seconds = opts.quick ? 0.05 : 0.3;
+    const std::vector<cv::Size> sizes = opts.quick
+        ? std::vector<cv::Size>{{640, 480}, {1920, 1080}}
+        : std::vector<cv::Size>{{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+    const float roi_ratios[] = {0.3f, 1.0f};
+    const int blurs[] = {5, 21};
+    const double densities[] = {0.0, 0.01, 0.1};
+
+    for (const cv::Size& size : sizes) {
+        for (double density : densities) {
+            std::vector<cv::Mat> frames;
+            for (float roi : roi_ratios) {
+                for (int blur : blurs) {
+                    for (bool fixed : {false, true}) {
+                        char name[128];
+                        std::snprintf(name, sizeof(name),
+                                      "detector/%dx%d/roi%.0f/blur%d/motion%g%s",
+                                      size.width, size.height, roi * 100, blur, density * 100,
+                                      fixed ? "/fixed16" : "");
+                        if (!selected(name)) continue;
+                        if (frames.empty()) frames = syntheticFrames(size, density, 6);
+                        report(benchDetector(name, frames, detectorConfig(roi, blur, fixed),
+                                             nullptr, min_seconds));
+                    }
+                }
+            }
+        }
+    }
+
+    // Static frames should not allocate at all; with motion, labeling does
+    for (double density : {0.0, 0.01}) {
+        char name[128];
+        std::snprintf(name, sizeof(name), "allocations/1280x720/motion%g", density * 100);
+        if (!selected(name)) continue;
+        report(benchAllocations(name, syntheticFrames(cv::Size(1280, 720), density, 6),
+                                detectorConfig(1.0f, 21, false), opts.quick ? 50 : 300));
+    }
+
+    // Strip-parallel detection on large frames, checked against strips = 1
+    const int strip_counts[] = {1, 4, 8};
+    WorkerPool strip_pool;
+    int strip_mismatches = 0;
+    for (const cv::Size& size : {cv::Size(1920, 1080), cv::Size(3840, 2160)}) {
+        std::vector<cv::Mat> frames;
+        for (int strips : strip_counts) {
+            char name[128];
+            std::snprintf(name, sizeof(name), "strips/%dx%d/motion1/strips%d",
+                          size.width, size.height, strips);
+            if (!selected(name)) continue;
+            if (frames.empty()) frames = syntheticFrames(size, 0.01, 6);
+            MotionDetector::Config cfg = detectorConfig(1.0f, 21, false);
+            cfg.strips = strips;
+            if (!stripsMatch(frames, cfg, strip_pool)) {
+                std::cerr << name << ": events differ from strips=1" << std::endl;
+                ++strip_mismatches;
+            }
+            report(benchDetector(name, frames, cfg, &strip_pool, min_seconds));
+        }
+    }
+
+    // Background checkpoints of a full-frame ROI plus the full-frame model
+    int checkpoint_mismatches = 0;
+    for (const cv::Size& size : {cv::Size(1920, 1080), cv::Size(3840, 2160)}) {
+        std::vector<cv::Mat> frames;
+        for (bool save : {true, false}) {
+            char name[128];
+            std::snprintf(name, sizeof(name), "checkpoint/%dx%d/%s",
+                          size.width, size.height, save ? "save" : "load");
+            if (!selected(name)) continue;
+            if (frames.empty()) frames = syntheticFrames(size, 0.01, 6);
+            MotionDetector::Config cfg = detectorConfig(1.0f, 21, false);
+            cfg.full_frame_background = true;
+            bool match = false;
+            report(benchCheckpoint(name, frames, cfg, save, min_seconds, match));
+            if (!match) {
+                std::cerr << name << ": restored detector differs from the original" << std::endl;
+                ++checkpoint_mismatches;
+            }
+        }
+    }
+
+    const char* accuracy_uris[] = {
+        "synthetic://640x480@0?blobs=3&noise=2",
+        "synthetic://1280x720@0?blobs=5&noise=4",
+        "synthetic://1920x1080@0?blobs=8&noise=6&speed=12",
+    };
+    for (const char* uri : accuracy_uris) {
+        std::string name = std::string("accuracy/") + (uri + std::strlen("synthetic://"));
+        if (selected(name)) report(benchAccuracy(name, uri, opts.quick ? 60 : 300));
+    }
+
+    const int per_producer = opts.quick ? 20000 : 200000;
+    const std::pair<int, int> shapes[] = {{1, 1}, {4, 1}, {4, 4}};
+    for (const auto& shape : shapes) {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), "/%dp%dc", shape.first, shape.second);
+        std::string mutex_name = std::string("queue/frame_mutex") + suffix;
+        std::string lockfree_name = std::string("queue/frame_lockfree") + suffix;
+        std::string thread_name = std::string("queue/thread_queue") + suffix;
+        if (selected(mutex_name)) {
+            report(benchFrameQueue(mutex_name, false, shape.first, shape.second, per_producer));
+        }
+        if (selected(lockfree_name)) {
+            report(benchFrameQueue(lockfree_name, true, shape.first, shape.second, per_producer));
+        }
+        if (selected(thread_name)) {
+            report(benchThreadQueue(thread_name, shape.first, shape.second, per_producer));
+        }
+    }
+
+    if (!writeJson(opts.out, results)) {
+        std::cerr << "Failed to write " << opts.out << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << results.size() << " results to " << opts.out << "\n";
+    if (strip_mismatches > 0) return 3;
+    if (checkpoint_mismatches > 0) return 4;
+
+    if (!opts.baseline.empty()) {
+        auto baseline = readBaseline(opts.baseline);
+        if (baseline.empty()) {
+            std::cerr << "No results in baseline " << opts.baseline << std::endl;
+            return 1;
+        }
+        return compare(results, baseline, opts.tolerance) > 0 ? 2 : 0;
+    }
+    return 0;
+}
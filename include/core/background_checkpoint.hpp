@@ -0,0 +1,79 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "motion_detector.hpp"
+#include "../models/background_snapshot.hpp"
+#include "../models/background_checkpoint_format.hpp"
+
+// Writes snapshot to path atomically (temp file, then rename)
+bool saveBackgroundCheckpoint(const std::string& path, const BackgroundSnapshot& snapshot);
+// Maps and validates a checkpoint; false if missing, truncated or foreign.
+// The models wrap the mapping, which snapshot.storage keeps alive.
+bool loadBackgroundCheckpoint(const std::string& path, BackgroundSnapshot& snapshot);
+
+/**
+ * Periodic background checkpoints for warm restarts.
+ *
+ * checkpoint() runs on the stream's processing thread: once per interval
+ * it copies the detector's models into a buffer owned by the writer
+ * thread, which saves them off the processing path. While a write is
+ * still running the next checkpoint is skipped, so the buffer is reused
+ * and processing never waits for the disk. load() maps the last
+ * checkpoint instead of reading it, so it takes well under a millisecond
+ * even for 4K models.
+ */
+class BackgroundCheckpointer {
+public:
+    struct Options {
+        std::string path;          // e.g. "background_0.mdbg"
+        int interval_ms = 60000;
+    };
+
+    struct Stats {
+        uint64_t written = 0;
+        uint64_t failed = 0;
+        uint64_t skipped = 0;      // previous write still running
+        uint64_t bytes = 0;        // of the last checkpoint written
+        double snapshot_ms = 0.0;  // processing-thread time, total
+        double write_ms = 0.0;     // writer time, total
+        double load_ms = 0.0;
+        size_t loaded_models = 0;
+    };
+
+    explicit BackgroundCheckpointer(const Options& opts);
+    ~BackgroundCheckpointer();
+
+    BackgroundCheckpointer(const BackgroundCheckpointer&) = delete;
+    BackgroundCheckpointer& operator=(const BackgroundCheckpointer&) = delete;
+
+    bool start();
+    // Waits for a write in progress, then joins the writer
+    void stop();
+
+    bool load(BackgroundSnapshot& out);
+    // Processing thread only. With force the interval is ignored and a
+    // write in progress is waited for (use for the last checkpoint). as is
+    // passed on to MotionDetector::snapshotBackground.
+    void checkpoint(const MotionDetector& detector, uint64_t frame_id, bool force = false,
+                    const MotionDetector::Config* as = nullptr);
+
+    Stats stats() const;
+    const std::string& path() const { return opts_.path; }
+
+private:
+    void run();
+
+    Options opts_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    bool busy_ = false;            // snapshot_ belongs to the writer
+    BackgroundSnapshot snapshot_;
+    std::chrono::steady_clock::time_point next_due_;  // processing thread only
+    Stats stats_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "event_log.hpp"
+#include "motion_detector.hpp"
+#include "../models/mdcfg.hpp"
+#include "../models/motion_event.hpp"
+
+/**
+ * Headless batch processing of a video file.
+ *
+ * Decodes as fast as possible with no visualization and stops at end of
+ * file. The file is split into segments that run in parallel on a
+ * WorkerPool; each segment starts warmup_frames early so its background
+ * has converged by the time its first reported frame comes up. Events
+ * from the warm-up are discarded. The earliest unfinished segment writes
+ * straight to the log; later ones buffer until every segment before them
+ * is done, so the log stays in frame order. A segment whose buffer fills
+ * up pauses, keeping its decoder and detector, and gives its worker back;
+ * it resumes once it is the earliest, so buffering stays bounded.
+ *
+ * frame_id is the absolute frame index and timestamp_ms is derived from it
+ * and the file's fps, so the merged log lines up with a sequential run
+ * (segments = 1) apart from the background state at segment boundaries.
+ */
+class BatchRunner {
+public:
+    struct Options {
+        std::string path;
+        size_t segments = 0;        // 0 = one per worker
+        size_t workers = 0;         // 0 = one per core
+        size_t warmup_frames = 150;
+        size_t max_buffered_events = 10000;  // per segment, before it pauses
+        MotionDetectorConfig config;
+    };
+
+    struct Report {
+        uint64_t frames = 0;        // reported frames (excludes warm-up)
+        uint64_t decoded = 0;       // including warm-up overlap
+        size_t segments = 0;
+        double seconds = 0.0;
+        double fps() const { return seconds > 0 ? frames / seconds : 0.0; }
+    };
+
+    explicit BatchRunner(const Options& opts);
+
+    // Blocks until the whole file is processed; events go to log in order
+    bool run(EventLog& log, Report& report);
+
+private:
+    struct Segment {
+        uint64_t begin = 0;         // first reported frame
+        uint64_t end = 0;           // one past the last; UINT64_MAX = until EOF
+        std::mutex mutex;
+        bool live = false;          // events go straight to the log
+        bool paused = false;        // buffer full, waiting to go live
+        std::vector<MotionEvent> events;  // buffered until live
+        // Decoding state, kept across a pause
+        cv::VideoCapture cap;
+        std::unique_ptr<MotionDetector> detector;
+        uint64_t next = 0;          // next frame to decode
+        uint64_t frames = 0;
+        uint64_t decoded = 0;
+        bool ok = false;
+        bool done = false;          // guarded by run()'s done mutex
+    };
+
+    // Returns false when the segment paused before its end
+    bool processSegment(Segment& segment, double fps, EventLog& log) const;
+    // Writes segment's buffered events, then lets it write directly.
+    // Returns true if it was paused and must be resubmitted.
+    static bool goLive(Segment& segment, EventLog& log);
+
+    Options opts_;
+};
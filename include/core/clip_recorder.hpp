@@ -0,0 +1,118 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "worker_pool.hpp"
+#include "../queues/frame_queue.hpp"
+
+/**
+ * Motion clips with pre-roll.
+ *
+ * Every analyzed frame is JPEG-encoded on a WorkerPool into a per-stream
+ * ring of compressed frames covering the last pre_seconds. When motion
+ * starts, a clip opens at (now - pre_seconds); it takes the ring and every
+ * following frame until motion has been absent for post_seconds. A writer
+ * thread appends the clip's frames in order to
+ * <directory>/<prefix>_<trigger frame id>.mjpeg (concatenated JPEGs,
+ * playable with `ffplay -f mjpeg`).
+ *
+ * push() never blocks: with max_inflight encodes outstanding the frame is
+ * dropped from the recording (and counted). Encoded frames held in memory,
+ * ring plus not yet written, are capped at max_bytes; beyond that the
+ * oldest are evicted, written or not.
+ */
+class ClipRecorder {
+public:
+    struct Options {
+        std::string directory = "clips";
+        std::string prefix = "clip";
+        double pre_seconds = 3.0;
+        double post_seconds = 2.0;
+        size_t max_bytes = 32 * 1024 * 1024;
+        int jpeg_quality = 80;
+        size_t max_inflight = 4;
+    };
+
+    struct Stats {
+        uint64_t frames_encoded = 0;
+        uint64_t encode_dropped = 0;     // pool busy, never encoded
+        uint64_t bytes_encoded = 0;
+        double encode_ms = 0.0;          // summed over workers
+        uint64_t clips = 0;              // completed clip files
+        uint64_t frames_written = 0;
+        uint64_t bytes_written = 0;
+        uint64_t evicted_unwritten = 0;  // clip frames lost to max_bytes
+        double write_seconds = 0.0;      // writer busy time
+        double writeMBps() const { return write_seconds > 0 ? bytes_written / write_seconds / 1e6 : 0.0; }
+    };
+
+    // pool is not owned and must outlive the recorder
+    ClipRecorder(const Options& opts, WorkerPool& pool);
+    ~ClipRecorder();
+
+    ClipRecorder(const ClipRecorder&) = delete;
+    ClipRecorder& operator=(const ClipRecorder&) = delete;
+
+    bool start();
+    // Waits for queued encodes, finishes the open clip and joins the writer
+    void stop();
+
+    // One analyzed frame and whether motion is active in it. Call from a
+    // single thread (the stream's processing thread).
+    void push(const TimestampedFrame& tf, bool motion);
+
+    Stats stats() const;
+
+private:
+    struct Encoded {
+        uint64_t frame_id;
+        int64_t timestamp_ms;
+        std::vector<uchar> jpeg;
+    };
+    using EncodedPtr = std::shared_ptr<const Encoded>;
+
+    struct Clip {
+        int64_t start_ms;
+        uint64_t end_frame = UINT64_MAX;  // last frame, set when motion ends
+        std::string path;
+    };
+
+    void encode(cv::Mat frame, uint64_t frame_id, int64_t timestamp_ms);
+    void insert(EncodedPtr frame);
+    void evict();
+    uint64_t settledBefore() const;
+    void writerLoop();
+    bool writeFrames(Clip& clip, std::vector<EncodedPtr>& batch, std::unique_lock<std::mutex>& lock);
+
+    Options opts_;
+    WorkerPool& pool_;
+    std::thread writer_;
+    bool running_ = false;
+
+    // Processing thread only
+    bool recording_ = false;
+    int64_t last_motion_ms_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<EncodedPtr> ring_;        // by frame_id
+    size_t ring_bytes_ = 0;
+    std::multiset<uint64_t> inflight_;   // frame ids being encoded
+    std::atomic<size_t> inflight_count_{0};
+    uint64_t pushed_upto_ = 0;           // highest frame id pushed
+    bool any_pushed_ = false;
+    std::deque<Clip> clips_;             // front is being written
+    uint64_t written_upto_ = 0;          // last frame id written to any clip
+    bool any_written_ = false;
+    bool stopping_ = false;
+    FILE* file_ = nullptr;               // writer thread only
+    Stats stats_;
+};
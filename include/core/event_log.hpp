@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "motion_log.hpp"
+#include "../models/motion_event.hpp"
+#include "../queues/bounded_ring.hpp"
+
+/**
+ * Streaming sink for MotionEvents.
+ *
+ * append() is lock-free and never blocks the detector: events go into a
+ * fixed-size ring and are dropped (and counted) if the writer falls behind.
+ * A background thread drains the ring in batches into CSV or binary motion
+ * log (.mdlog) files, flushing
+ * every flush_interval_ms and rotating to a new file once max_file_bytes is
+ * reached. Memory use is bounded by buffer_capacity, however long it runs.
+ *
+ * Files: <path>, then <stem>.1<ext>, <stem>.2<ext>, ... With max_files > 0
+ * only the newest max_files segments are kept.
+ */
+class EventLog {
+public:
+    enum class Format { CSV, BINARY };
+
+    struct Options {
+        std::string path = "motion_data.csv";
+        Format format = Format::CSV;
+        size_t buffer_capacity = 8192;
+        size_t batch_size = 256;
+        size_t max_file_bytes = 64 * 1024 * 1024;
+        size_t max_files = 0;  // 0 = keep every segment
+        int flush_interval_ms = 1000;
+    };
+
+    explicit EventLog(const Options& opts);
+    ~EventLog();
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    bool start();
+    // Drains everything appended so far, then closes the current file
+    void stop();
+
+    bool append(const MotionEvent& event);
+    // For offline producers that must not lose events: waits for room
+    void appendBlocking(const MotionEvent& event);
+
+    uint64_t written() const { return written_; }
+    uint64_t dropped() const { return dropped_; }
+    // Path of the segment currently being written
+    std::string currentPath() const;
+
+private:
+    void writerLoop();
+    size_t drainBatch(std::vector<MotionEvent>& batch);
+    void writeBatch(const std::vector<MotionEvent>& batch);
+    void flushSegment();
+    bool isOpen() const;
+    bool openSegment(size_t index);
+    std::string segmentPath(size_t index) const;
+
+    Options opts_;
+    BoundedRing<MotionEvent> ring_;
+    std::thread writer_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    // Writer thread only
+    FILE* file_ = nullptr;
+    MotionLogWriter binary_;
+    size_t segment_ = 0;
+    size_t segment_bytes_ = 0;
+};
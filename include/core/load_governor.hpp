@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "motion_detector.hpp"
+
+/**
+ * Per-stream load governor: trades quality for keeping up in real time.
+ *
+ * The consumer reports each analyzed frame's processing time and the
+ * capture queue depth. Once per window the governor computes
+ *   load = processing time / wall time (1.0: processing never idles)
+ *   fill = mean queue depth / queue capacity
+ * Overload (load > high_load or fill > high_fill) moves one rung down the
+ * ladder, at most once per settle_ms so the last step can take effect.
+ * It moves one rung up after recover_ms in which the queue stayed nearly
+ * empty and the load, scaled by what that rung was measured to cost when
+ * it was left, would stay below high_load, so it doesn't oscillate
+ * between two rungs.
+ */
+class LoadGovernor {
+public:
+    // Cumulative settings of one rung; rung 0 is the configured quality
+    struct Rung {
+        const char* name;        // what this rung adds to the one above
+        double scale;            // multiplies the processing scale
+        int rate_divisor;        // analyze 1 in N of the frames otherwise analyzed
+        double blur;             // multiplies blur_kernel
+        bool visualize;          // attach frames for display and preview
+    };
+    static const std::vector<Rung>& ladder();
+    // cfg at rung's settings; a pyramid is deepened instead of rescaled.
+    // Models are resampled on a scale change, not re-learned.
+    static void applyRung(const Rung& rung, MotionDetector::Config& cfg);
+
+    struct Options {
+        int window_ms = 1000;
+        int settle_ms = 3000;
+        int recover_ms = 10000;
+        double high_load = 0.85;
+        double high_fill = 0.5;
+        double low_fill = 0.1;
+        int max_level = -1;      // deepest rung, -1 = whole ladder
+    };
+
+    struct Transition {
+        int from = 0;
+        int to = 0;
+        uint64_t frame_id = 0;
+        int64_t timestamp_ms = 0;
+        double load = 0.0;
+        double fill = 0.0;
+        std::string reason;
+    };
+
+    explicit LoadGovernor(const Options& opts);
+
+    // Processing thread: one call per analyzed frame, now_ns from a
+    // monotonic clock. True when the level changed; out describes why.
+    bool observe(int64_t now_ns, int64_t process_ns, size_t queue_depth, size_t queue_capacity,
+                 uint64_t frame_id, int64_t timestamp_ms, Transition& out);
+
+    // Safe from any thread
+    int level() const { return level_.load(std::memory_order_relaxed); }
+    const Rung& rung() const { return ladder()[level()]; }
+    uint64_t transitions() const { return transitions_.load(std::memory_order_relaxed); }
+    // Load of the last complete window, in thousandths
+    int lastLoadMilli() const { return last_load_milli_.load(std::memory_order_relaxed); }
+
+private:
+    void change(int to, int64_t now_ns, double load, double fill, uint64_t frame_id,
+                int64_t timestamp_ms, std::string reason, Transition& out);
+
+    Options opts_;
+    int max_level_;
+    std::atomic<int> level_{0};
+    std::atomic<uint64_t> transitions_{0};
+    std::atomic<int> last_load_milli_{0};
+
+    // Current window
+    int64_t window_start_ns_ = 0;
+    int64_t busy_ns_ = 0;
+    double depth_sum_ = 0.0;
+    uint64_t samples_ = 0;
+
+    int64_t last_change_ns_ = 0;
+    int64_t calm_since_ns_ = 0;      // 0 = not calm
+    // cost_[i]: load at rung i / load at rung i + 1, measured on the way down
+    std::vector<double> cost_;
+    double load_before_step_ = 0.0;
+    bool measure_step_ = false;
+};
@@ -0,0 +1,198 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Pipeline metrics: lock-free latency histograms and gauges, rendered in
+ * the Prometheus text format.
+ *
+ * Built only with MOTION_METRICS=1 (CMake option MOTION_ENABLE_METRICS).
+ * Otherwise every type below is an empty inline stub and metricsNow()
+ * returns 0, so instrumented code compiles down to nothing.
+ *
+ * motion_stage_seconds{stage="update"} only covers a separate background
+ * update pass: the unfused kernel, seeding, and the full-frame model
+ * refresh. With the default fused kernel the ROI update runs inside the
+ * diff pass and is counted in stage="diff".
+ */
+
+#if MOTION_METRICS
+
+// Monotonic clock in nanoseconds for latency measurements
+inline int64_t metricsNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * HDR-style log-linear histogram of nanosecond values. Each power of two
+ * is split into kSubBuckets linear buckets (~6% relative error) up to
+ * 2^kMaxExponent ns; larger values land in the last bucket. record() is
+ * a relaxed fetch_add, so any number of threads can record concurrently.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kMaxExponent = 40;  // ~18 minutes
+    static constexpr int kBuckets = (kMaxExponent - kSubBits + 2) * kSubBuckets;
+
+    void record(int64_t ns);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sumNs() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t maxNs() const { return max_.load(std::memory_order_relaxed); }
+    // Approximate value at quantile q (0..1) from a racy snapshot
+    uint64_t quantileNs(double q) const;
+
+    static int bucketOf(uint64_t ns);
+    static uint64_t bucketMid(int bucket);
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+class Gauge {
+public:
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * Owns every metric for the life of the process, so the references it
+ * hands out never dangle. Registering the same name and labels twice
+ * returns the same metric. Labels are preformatted, e.g. stream="0".
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry& global();
+
+    LatencyHistogram& histogram(const std::string& name, const std::string& help,
+                                const std::string& labels);
+    Gauge& gauge(const std::string& name, const std::string& help,
+                 const std::string& labels);
+
+    // Prometheus text exposition; histograms are exported as summaries
+    std::string render() const;
+
+private:
+    struct Series {
+        std::string labels;
+        std::unique_ptr<LatencyHistogram> histogram;
+        std::unique_ptr<Gauge> gauge;
+    };
+    struct Family {
+        std::string name;
+        std::string help;
+        bool is_histogram;
+        std::vector<Series> series;
+    };
+    Series& find(const std::string& name, const std::string& help,
+                 const std::string& labels, bool is_histogram);
+
+    mutable std::mutex mutex_;
+    std::vector<Family> families_;
+};
+
+/**
+ * Periodically renders the registry to a file (written to a temp file and
+ * renamed, as the node_exporter textfile collector expects) and/or serves
+ * it on a unix socket: each connection gets an HTTP/1.0 response, so
+ * `curl --unix-socket PATH http://localhost/metrics` works.
+ */
+class MetricsExporter {
+public:
+    struct Options {
+        std::string path;            // file output, empty = none
+        std::string socket_path;     // unix socket, empty = none
+        int interval_ms = 5000;      // file refresh period
+    };
+
+    explicit MetricsExporter(const Options& opts);
+    ~MetricsExporter();
+
+    bool start();
+    void stop();
+
+private:
+    void run();
+    bool writeFile(const std::string& text) const;
+    void serveClients();
+
+    Options opts_;
+    int listen_fd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+#else  // !MOTION_METRICS
+
+inline int64_t metricsNow() { return 0; }
+
+class LatencyHistogram {
+public:
+    void record(int64_t) {}
+};
+
+class Gauge {
+public:
+    void set(int64_t) {}
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& global() { static MetricsRegistry r; return r; }
+    LatencyHistogram& histogram(const std::string&, const std::string&, const std::string&) {
+        return histogram_;
+    }
+    Gauge& gauge(const std::string&, const std::string&, const std::string&) { return gauge_; }
+    std::string render() const { return std::string(); }
+
+private:
+    LatencyHistogram histogram_;
+    Gauge gauge_;
+};
+
+class MetricsExporter {
+public:
+    struct Options {
+        std::string path;
+        std::string socket_path;
+        int interval_ms = 5000;
+    };
+    explicit MetricsExporter(const Options&) {}
+    bool start() { return false; }
+    void stop() {}
+};
+
+#endif  // MOTION_METRICS
+
+/**
+ * Times consecutive stages: split() returns the time since the previous
+ * split (or start) in ns. Free when metrics are compiled out.
+ */
+class StageTimer {
+public:
+    void start() { last_ = metricsNow(); }
+    int64_t split() {
+        int64_t now = metricsNow();
+        int64_t elapsed = now - last_;
+        last_ = now;
+        return elapsed;
+    }
+
+private:
+    int64_t last_ = 0;
+};
@@ -3,30 +3,130 @@
 #include <opencv2/opencv.hpp>
 #include <thread>
 #include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include "../queues/frame_queue.hpp"
+#include "../queues/broadcast_channel.hpp"
 #include "../queues/thread_queue.hpp"
 #include "../models/mdcfg.hpp"
 #include "../models/detection_result.hpp"
+#include "background_checkpoint.hpp"
+#include "clip_recorder.hpp"
+#include "event_log.hpp"
+#include "load_governor.hpp"
+#include "metrics.hpp"
+#include "motion_stats.hpp"
+#include "shm_frame_publisher.hpp"
+
+class VideoCapture;
 
 class MotionConsumer {
 public:
+    using EpisodeCallback = std::function<void(const MotionEpisode&)>;
+    using GovernorCallback = std::function<void(const LoadGovernor::Transition&)>;
+
     MotionConsumer(FrameQueue& buffer,
                    ThreadQueue<MotionDetectorConfig>& config_queue,
-                   ThreadQueue<DetectionResult>& result_queue);
+                   BroadcastChannel<DetectionResult>& results);
     ~MotionConsumer();
     void start();
     void stop();
-    void exportCSV(const std::string& path) const;
+
+    // Pooled mode: process up to max_frames already queued frames without
+    // waiting. Returns the number of frames processed.
+    size_t drain(size_t max_frames);
+    // Events are appended to log (not owned) as they are produced
+    void setEventLog(EventLog* log) { event_log_ = log; }
+    // Frames and episode state go to recorder (not owned); call before start()
+    void setClipRecorder(ClipRecorder* recorder) { clip_recorder_ = recorder; }
+    // Frames, masks and events go to publisher (not owned); call before start()
+    void setShmPublisher(ShmFramePublisher* publisher) { shm_publisher_ = publisher; }
+    // Restores the detector's background from checkpointer's last
+    // checkpoint (not owned), then checkpoints periodically; call before
+    // start()
+    void setCheckpointer(BackgroundCheckpointer* checkpointer);
+    // Writes a last checkpoint and detaches the checkpointer; stop() calls
+    // it, pooled owners call it once processing has stopped
+    void saveCheckpoint();
+    size_t restoredModels() const { return detector_.restoredModels(); }
+    // Lets governor (not owned) degrade the detector settings, capture's
+    // analysis rate and frame attachment under overload; callback gets
+    // every level change on the processing thread. Call before start().
+    void setLoadGovernor(LoadGovernor* governor, VideoCapture* capture = nullptr,
+                         GovernorCallback callback = nullptr);
+    // Pool for the detector's strips (not owned); call before start()
+    void setWorkerPool(WorkerPool* pool) { detector_.setWorkerPool(pool); }
+    uint64_t detectorAllocations() const { return detector_.allocations(); }
+    // Tile gating totals since start (see MotionDetector::FrameStats)
+    uint64_t tilesProcessed() const { return tiles_processed_.load(std::memory_order_relaxed); }
+    uint64_t tilesSkipped() const { return tiles_skipped_.load(std::memory_order_relaxed); }
+    // Attach the captured frame to at most fps results per second so they
+    // can be rendered; fps <= 0 is headless (results carry no frame).
+    // Default attaches every frame.
+    void setDisplayRate(double fps);
+    // Also attach frames to at most fps results per second for the preview
+    // server while it has viewers; fps <= 0 turns it off. Combined with the
+    // display rate, whichever is faster wins.
+    void setPreviewRate(double fps);
+    // Call before start(); labels are Prometheus labels, e.g. stream="0"
+    void enableMetrics(const std::string& labels);
+    // Call before start(). Finished motion episodes are passed to callback
+    // on the processing thread.
+    void setEpisodeOptions(const EpisodeDetector::Options& opts);
+    void setEpisodeCallback(EpisodeCallback callback) { episode_callback_ = std::move(callback); }
+    // Reports episodes still open; stop() calls it, pooled owners call it
+    // once processing has stopped
+    void finishEpisodes();
+    // Live per-ROI statistics, safe to call while running
+    std::vector<MotionStats::RoiSummary> statsSummary() const;
+
+    static MotionDetector::Config toDetectorConfig(const MotionDetectorConfig& config);
     
 private:
     void processLoop();
+    void processFrame(TimestampedFrame& tf);
     void applyConfig(const MotionDetectorConfig& config);
+    void applyGovernedConfig();
+    // Checkpoints keep the configured scale, not a governor rung's (the
+    // blur is recorded as learned, so a blurred rung's models are not
+    // restored at the configured blur)
+    const MotionDetector::Config* checkpointConfig() const {
+        return governor_ ? &base_config_ : nullptr;
+    }
     
     FrameQueue& buffer_;
     ThreadQueue<MotionDetectorConfig>& config_queue_;
-    ThreadQueue<DetectionResult>& result_queue_;
+    BroadcastChannel<DetectionResult>& results_;
     
     MotionDetector detector_;  // Owned, not reference
     std::thread processing_thread_;
     std::atomic<bool> running_{false};
+    EventLog* event_log_ = nullptr;
+    ClipRecorder* clip_recorder_ = nullptr;
+    ShmFramePublisher* shm_publisher_ = nullptr;
+    BackgroundCheckpointer* checkpointer_ = nullptr;
+    uint64_t last_frame_id_ = 0;
+    LoadGovernor* governor_ = nullptr;
+    VideoCapture* governed_capture_ = nullptr;
+    GovernorCallback governor_callback_;
+    MotionDetector::Config base_config_;  // as configured, before the governor
+    std::atomic<int64_t> display_interval_ms_{0};  // -1 = headless
+    std::atomic<int64_t> preview_interval_ms_{-1};  // -1 = no preview viewers
+    int64_t last_display_ms_ = INT64_MIN;
+    std::atomic<uint64_t> tiles_processed_{0};
+    std::atomic<uint64_t> tiles_skipped_{0};
+
+    mutable std::mutex stats_mutex_;
+    MotionStats stats_;
+    std::vector<MotionEpisode> finished_;  // processing thread only
+    EpisodeCallback episode_callback_;
+
+    struct Metrics {
+        LatencyHistogram* queue_wait = nullptr;
+        LatencyHistogram* end_to_end = nullptr;
+        Gauge* queue_depth = nullptr;
+        Gauge* result_lag = nullptr;
+        Gauge* governor_level = nullptr;
+    } metrics_;
 };
\ No newline at end of file
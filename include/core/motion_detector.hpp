@@ -1,9 +1,13 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <functional>
+#include <memory>
 #include <vector>
-#include <fstream>
+#include "metrics.hpp"
+#include "worker_pool.hpp"
 #include "../models/roi_config.hpp"
 #include "../models/motion_event.hpp"
+#include "../models/background_snapshot.hpp"
 
 class MotionDetector {
 public:
@@ -13,7 +17,48 @@ public:
         int min_contour_area = 500;
         double learning_rate = 0.01;
         ROIConfig roi;
-        bool draw_roi = true;
+        // Several named ROIs; replaces roi when not empty. Gray conversion,
+        // downscale and blur run once over their union, while each ROI keeps
+        // its own background and thresholds and reports its own event.
+        std::vector<ROIConfig> rois;
+        bool fused_kernel = true;  // single-pass diff/threshold/update
+        bool visualize = true;     // false: results carry no frame to render (headless)
+        // 8.8 fixed-point background in uint16_t instead of float: half the
+        // per-ROI state and memory traffic. Always uses the fused kernel.
+        bool fixed_point = false;
+
+        // Detection runs on the ROI downscaled by process_scale (0 < s <= 1),
+        // or by 2^pyramid_levels via pyrDown when pyramid_levels > 0.
+        // blur_kernel and min_contour_area stay in full-resolution units.
+        double process_scale = 1.0;
+        int pyramid_levels = 0;
+        // Re-measure the largest box at full resolution when motion is found
+        bool refine = false;
+        // Morphology and labeling run only on tiles (tile_size px square, in
+        // processing coordinates) that contain changed pixels, plus a halo.
+        // 0 processes the whole ROI every frame.
+        int tile_size = 16;
+        // Blur, diff, morphology and labeling run on this many horizontal
+        // strips in parallel on the pool given to setWorkerPool(). Strips
+        // read a halo of the blur and dilate reach and their components are
+        // merged across strip edges, so events match strips = 1. A strip
+        // without changed pixels is skipped whole instead of tile gating.
+        int strips = 1;
+        // Also keep a background for the whole frame (processing scale),
+        // refreshed one band of tile rows per frame, 1/refresh_bands of the
+        // frame at a time. New or moved ROIs are seeded from it, so ROI
+        // changes take effect on the next frame without re-learning.
+        bool full_frame_background = false;
+        int refresh_bands = 8;
+    };
+
+    // Tile gating counters of the last process() call
+    struct FrameStats {
+        int tiles_total = 0;
+        int tiles_dirty = 0;
+        int regions = 0;  // connected dirty areas labeled
+        // Summed over all ROIs
+        int tilesSkipped() const { return tiles_total - tiles_dirty; }
     };
     explicit MotionDetector();
     explicit MotionDetector(const Config& cfg);
@@ -21,18 +66,146 @@ public:
     void setROI(const ROIConfig& roi);
     ROIConfig getROI() const;
 
+    // Drops every background model, including the full-frame one, and any
+    // snapshot waiting to be restored
     void resetBackground();
+    // Copies the learned background models into out, reusing its buffers.
+    // With as, models are resampled to as's processing scale and recorded
+    // with its scale settings (e.g. the configured ones while a load
+    // governor runs the detector degraded); the blur recorded is always
+    // the one they were learned at.
+    void snapshotBackground(BackgroundSnapshot& out, const Config* as = nullptr) const;
+    // Models of snapshot are adopted on the next process() call by ROIs
+    // whose frame size, rectangle, processing size and settings match;
+    // the others learn from that frame as usual
+    void restoreBackground(BackgroundSnapshot&& snapshot);
+    // Models adopted from the last restoreBackground()
+    size_t restoredModels() const { return restored_models_; }
     void setConfig(const Config& cfg);
+    const Config& config() const { return config_; }
+    // Pool for Config::strips (not owned); without one strips run in turn
+    void setWorkerPool(WorkerPool* pool) { pool_ = pool; }
 
+    // Returns the event of the first ROI; events() has one per ROI
     MotionEvent process(const cv::Mat& frame, uint64_t id, int64_t ts);
-    cv::Mat getVisualization() const;
-    void exportCSV(const std::string& path) const;
+    const std::vector<MotionEvent>& events() const { return events_; }
+    // Accepted motion boxes of the last process() call over all ROIs,
+    // full-frame coordinates
+    const std::vector<cv::Rect>& boxes() const { return boxes_; }
+    const FrameStats& frameStats() const { return stats_; }
+    // Dilated motion mask of the last process() call over all ROIs:
+    // CV_8UC1, maskSize() at processing scale, covering maskRect() of the
+    // frame. out may wrap external memory of that size (not reallocated).
+    void motionMask(cv::Mat& out) const;
+    cv::Size maskSize() const { return blurred_.size(); }
+    const cv::Rect& maskRect() const { return union_rect_; }
+
+    // Scratch and mask buffer (re)allocations made by process(), flat once
+    // warmed up. Labeling still allocates inside OpenCV when there is
+    // motion; motion_bench counts every heap allocation per frame.
+    uint64_t allocations() const { return allocations_; }
+
+    // Record per-stage timings into motion_stage_seconds{<labels>,stage=...}
+    void enableMetrics(const std::string& labels);
     
 private:
+    // Per-ROI detection state
+    struct RoiState {
+        cv::Rect rect;          // full-frame
+        cv::Rect local;         // processing coordinates within the union
+        cv::Mat background;     // CV_32F or CV_16U (8.8), local.size()
+        cv::Rect model_rect;    // full-frame rect background was learned for
+        cv::Mat thresh;         // dilated in place before labeling
+        cv::Mat labels;         // CV_32S component labels
+        const uchar* thresh_data = nullptr;
+        bool initialized = false;
+    };
+
+    void syncRois();
+    void layoutRois(int frame_width, int frame_height);
+    MotionEvent detectRoi(size_t index, uint64_t id, int64_t ts, int frame_area);
+    enum Stage { CONVERT, DOWNSCALE, BLUR, DIFF, TILES, MORPHOLOGY, LABELING, UPDATE, kStageCount };
+    void endStage(Stage stage) { stage_ns_[stage] += stage_timer_.split(); }
+    void recordStages();
+    void countScratchAllocations();
+    void downscale(const cv::Mat& gray);
+    static cv::Size processingSize(const Config& cfg, const cv::Size& size);
+    cv::Rect localRect(const cv::Rect& rect, double sx, double sy, const cv::Rect& bounds) const;
+    cv::Rect toFullFrame(const cv::Rect& r, const cv::Rect& clip) const;
+    cv::Rect refineBox(const cv::Rect& box, const RoiState& roi, int threshold);
+    void findDirtyRegions(const cv::Mat& mask, int changed);
+    void resetRois();
+    void adoptSnapshot(const cv::Size& frame_size);
+    void refreshFrameBackground(const cv::Mat& frame);
+    bool seedFromFrameBackground(RoiState& roi, const cv::Size& size);
+    int backgroundType() const { return config_.fixed_point ? CV_16UC1 : CV_32FC1; }
+    void extractBlobs(RoiState& roi, int changed);
+    void labelBlobs(const cv::Mat& mask, cv::Mat& labels, const cv::Point& offset);
+    // Strip-parallel path (Config::strips > 1)
+    void layoutStrips(int rows);
+    void forEachStrip(size_t count, const std::function<void(size_t)>& fn);
+    void blurStrips(const cv::Mat& small, int blur);
+    int diffStrips(RoiState& roi, const cv::Mat& blurred, int threshold);
+    void extractBlobsStrips(RoiState& roi, int changed);
+    void mergeStripBlobs(const RoiState& roi, size_t count);
+
     Config config_;
-    cv::Mat background_;
-    cv::Mat last_viz_;
-    std::vector<MotionEvent> history_;
-    bool initialized_ = false;
+    std::vector<ROIConfig> roi_configs_;  // config_.rois, or just config_.roi
+    std::vector<RoiState> rois_;
+    cv::Rect union_rect_;
+    std::vector<MotionEvent> events_;
+    std::vector<cv::Rect> boxes_;
+
+    // Scratch buffers reused across frames; reallocated only on geometry change
+    cv::Mat gray_, small_, blurred_, bg_8u_, diff_, blurred_f_;
+    cv::Mat pyr_tmp_, refine_blur_, refine_bg_, refine_mask_;
+    cv::Mat dilate_kernel_;
+    // Connected components of the dilated mask, processing coordinates
+    // within the ROI, in a fixed order (see extractBlobs)
+    struct Blob {
+        cv::Rect box;
+        int area;  // pixels
+    };
+    std::vector<Blob> blobs_;
+    cv::Mat cc_stats_, cc_centroids_;
+    // Tile gating state: dirty flag per tile, flood-fill stack, merged regions
+    std::vector<uint8_t> tiles_;
+    std::vector<int> tile_stack_;
+    std::vector<cv::Rect> regions_;
+    // Full-frame background (full_frame_background): processing-scale model
+    // of the whole frame and the band refreshed next
+    cv::Mat frame_bg_, band_gray_, band_small_, band_blur_, band_mask_;
+    cv::Size frame_size_;
+    int refresh_band_ = 0;
+    // Size of the last processed frame, and models waiting to be restored
+    cv::Size input_size_;
+    BackgroundSnapshot pending_;
+    size_t restored_models_ = 0;
+    // Mappings backing restored models, kept until resetBackground()
+    std::vector<std::shared_ptr<void>> restored_storage_;
+    // One per strip: row range, halo scratch and per-strip components
+    struct Strip {
+        int y0 = 0, y1 = 0;
+        cv::Mat blur, dilated, stats, centroids;
+        int components = 0;  // labels 1..components-1 in its rows
+        int base = 0;        // union-find index of its label 1
+        int changed = 0;
+    };
+    std::vector<Strip> strips_;
+    // Union-find over strip components and the blob each root maps to
+    std::vector<int> blob_parent_, blob_slot_;
+    WorkerPool* pool_ = nullptr;
+    static constexpr int kMinStripRows = 32;
+    FrameStats stats_;
+    // Stage timings, summed over ROIs/regions within one frame
+    StageTimer stage_timer_;
+    int64_t stage_ns_[kStageCount] = {};
+    LatencyHistogram* stage_hist_[kStageCount] = {};
+    static constexpr int kDilateIterations = 2;
+    static constexpr size_t kScratchCount = 6;
+    const uchar* scratch_data_[kScratchCount] = {};
+    uint64_t allocations_ = 0;
+    // Processing size / union size of the current frame
+    double scale_x_ = 1.0, scale_y_ = 1.0;
 };
 
@@ -0,0 +1,53 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+/**
+ * Fused background-subtraction kernel.
+ *
+ * One sweep over a row replaces background_.convertTo(CV_8U), absdiff,
+ * threshold and accumulateWeighted:
+ *
+ *   b       = cvRound(bg[i])
+ *   mask[i] = |cur[i] - b| > threshold ? 255 : 0
+ *   bg[i]   = bg[i] * (1 - alpha) + cur[i] * alpha
+ *
+ * Tolerance vs. the OpenCV path: the mask is bit-identical for the same
+ * background; the background update may differ from accumulateWeighted by
+ * float rounding only (mul+add vs. FMA), |delta| <= 1e-4 per frame.
+ *
+ * Dispatches at runtime to AVX2 or SSE2 on x86, scalar elsewhere.
+ * Returns the number of mask pixels set.
+ */
+int fusedDiffThresholdUpdate(const uint8_t* cur, float* bg, uint8_t* mask,
+                             int n, int threshold, float alpha);
+
+/**
+ * Fixed-point variant on an 8.8 background (value * 256 in uint16_t),
+ * half the state and bandwidth of the float model:
+ *
+ *   b       = (bg[i] + 128) >> 8
+ *   mask[i] = |cur[i] - b| > threshold ? 255 : 0
+ *   bg[i]  += round((cur[i] * 256 - bg[i]) * alpha_q16 / 65536)
+ *
+ * alpha_q16 = round(alpha * 65536). The diff rounds halves up where the
+ * float path rounds them to even, and the update stops 0.2 gray levels
+ * short of a constant input (the float model converges fully). All code
+ * paths are bit-identical.
+ */
+int fusedDiffThresholdUpdate16(const uint8_t* cur, uint16_t* bg, uint8_t* mask,
+                               int n, int threshold, uint16_t alpha_q16);
+
+// Mat wrapper: cur CV_8UC1, bg CV_32FC1 (float model) or CV_16UC1 (8.8
+// model) of the same size; mask is (re)created
+int fusedDiffThresholdUpdate(const cv::Mat& cur, cv::Mat& bg, cv::Mat& mask,
+                             int threshold, double alpha);
+
+// Name of the code path picked by the dispatcher ("avx2", "sse2", "scalar")
+const char* fusedKernelPath();
+
+// Runs every SIMD path this CPU supports and the scalar path on the same
+// random rows, float and 8.8, and compares masks, counts and updated
+// backgrounds bit for bit. Returns the first SIMD path that differs, or
+// nullptr when they all match.
+const char* fusedKernelMismatch(uint32_t seed = 1);
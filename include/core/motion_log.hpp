@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../models/motion_event.hpp"
+#include "../models/motion_log_format.hpp"
+
+// CSV row layout shared by EventLog and motion_log_convert
+extern const char kMotionCsvHeader[];
+int formatMotionCsvRow(const MotionEvent& e, char* buf, size_t size);
+
+/**
+ * Parses one CSV data row. `columns` comes from the header line; the legacy
+ * exportCSV layout (4 header names, 8 values with the ROI) is recognized.
+ */
+bool parseMotionCsvRow(const std::string& line, const std::vector<std::string>& columns,
+                       MotionEvent& e);
+std::vector<std::string> parseMotionCsvHeader(const std::string& line);
+
+/**
+ * Column-oriented writer for the binary motion log.
+ *
+ * The file is sized for `capacity` rows up front (sparse on disk) so every
+ * column sits at a fixed offset. Rows are staged in memory and written
+ * column by column on flush(), after which the header count is updated;
+ * a crash loses at most the rows since the last flush.
+ */
+class MotionLogWriter {
+public:
+    MotionLogWriter() = default;
+    ~MotionLogWriter();
+
+    MotionLogWriter(const MotionLogWriter&) = delete;
+    MotionLogWriter& operator=(const MotionLogWriter&) = delete;
+
+    bool open(const std::string& path, uint64_t capacity);
+    bool append(const MotionEvent& e);
+    bool flush();
+    void close();
+
+    bool isOpen() const { return fd_ >= 0; }
+    bool full() const { return count_ + pending_.size() >= capacity_; }
+    uint64_t count() const { return count_ + pending_.size(); }
+
+    // Bytes per row across all columns
+    static size_t rowBytes();
+
+private:
+    int fd_ = -1;
+    uint64_t capacity_ = 0;
+    uint64_t count_ = 0;
+    std::vector<MotionLogColumn> columns_;
+    std::vector<MotionEvent> pending_;
+    std::vector<char> scratch_;
+};
+
+/**
+ * Memory-mapped reader. Column accessors return pointers straight into the
+ * mapping; count() re-reads the header, so a log that is still being
+ * written can be tailed.
+ */
+class MotionLogReader {
+public:
+    MotionLogReader() = default;
+    ~MotionLogReader();
+
+    MotionLogReader(const MotionLogReader&) = delete;
+    MotionLogReader& operator=(const MotionLogReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    uint64_t count() const;
+    const MotionLogHeader& header() const { return *header_; }
+
+    // nullptr if the column is missing or its element size differs from T
+    template<typename T>
+    const T* column(const char* name) const {
+        const MotionLogColumn* col = findColumn(name);
+        if (!col || col->elem_size != sizeof(T)) return nullptr;
+        return reinterpret_cast<const T*>(base_ + col->offset);
+    }
+
+    MotionEvent event(uint64_t row) const;
+
+private:
+    const MotionLogColumn* findColumn(const char* name) const;
+
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+    const MotionLogHeader* header_ = nullptr;
+    const MotionLogColumn* columns_ = nullptr;
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../models/motion_episode.hpp"
+#include "../models/motion_event.hpp"
+
+/**
+ * Online replacements for the post-run statistics in scripts/analyze.py.
+ * Every class here keeps a fixed amount of state, however long it runs.
+ */
+
+/**
+ * Mean and population variance by Welford's update. With window > 0 the
+ * weights decay exponentially (alpha = 2 / (window + 1)) once window
+ * samples are in, so the figures follow the recent past; window = 0 keeps
+ * the cumulative statistics.
+ */
+class RunningStats {
+public:
+    explicit RunningStats(double window = 0.0);
+
+    void add(double x);
+
+    uint64_t count() const { return count_; }
+    double mean() const { return mean_; }
+    double variance() const { return variance_; }
+    double stddev() const;
+
+private:
+    double alpha_;
+    uint64_t count_ = 0;
+    double mean_ = 0.0;
+    double variance_ = 0.0;
+};
+
+/**
+ * Streaming estimate of one quantile with the P-square algorithm (Jain &
+ * Chlamtac, 1985): five markers whose heights are adjusted by piecewise
+ * parabolic interpolation. Exact for the first five samples.
+ */
+class P2Quantile {
+public:
+    explicit P2Quantile(double q = 0.5);
+
+    void add(double x);
+    double value() const;
+    double quantile() const { return q_; }
+
+private:
+    double parabolic(int i, int d) const;
+    double linear(int i, int d) const;
+
+    double q_;
+    uint64_t count_ = 0;
+    double height_[5] = {};
+    double position_[5] = {1, 2, 3, 4, 5};
+    double desired_[5] = {};
+    double increment_[5] = {};
+};
+
+/**
+ * Debounced motion episodes from a stream of per-frame scores.
+ *
+ * An episode opens on the first score at or above the start threshold:
+ * `threshold` when set, else mean + sigma * stddev of the recent quiet
+ * scores (the live form of analyze.py's 2-sigma rule), never below
+ * min_score. It stays open while scores reach the release threshold,
+ * `release` of the way from the quiet mean up to the start threshold, and
+ * closes once they have not for gap_ms. Episodes shorter than
+ * min_duration_ms are discarded as flicker.
+ */
+class EpisodeDetector {
+public:
+    struct Options {
+        double threshold = 0.0;      // fixed start score (%), 0 = adaptive
+        double sigma = 2.0;
+        double min_score = 0.05;
+        double release = 0.5;        // hysteresis, see above
+        int64_t gap_ms = 1000;
+        int64_t min_duration_ms = 0;
+        double baseline_window = 900;  // frames, for the adaptive threshold
+    };
+
+    EpisodeDetector();
+    explicit EpisodeDetector(const Options& opts);
+
+    // Returns true when this event closed an episode, written to out
+    bool add(const MotionEvent& event, MotionEpisode& out);
+    // Closes an open episode at its last active frame (end of stream)
+    bool finish(MotionEpisode& out);
+
+    bool active() const { return active_; }
+    double startThreshold() const;
+
+private:
+    bool close(MotionEpisode& out);
+
+    Options opts_;
+    RunningStats baseline_;          // quiet frames only
+    bool active_ = false;
+    double release_threshold_ = 0.0;
+    double score_sum_ = 0.0;        // start..end_frame
+    double pending_sum_ = 0.0;      // frames after end_frame
+    uint64_t pending_frames_ = 0;
+    MotionEpisode current_;
+};
+
+/**
+ * Per-stream live statistics: for each ROI, cumulative and recent
+ * mean/stddev, p50/p95/p99 and episodes. State grows only with the
+ * number of ROIs.
+ */
+class MotionStats {
+public:
+    struct RoiSummary {
+        int roi_index = 0;
+        uint64_t frames = 0;
+        double mean = 0.0;
+        double stddev = 0.0;
+        double recent_mean = 0.0;
+        double recent_stddev = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+        uint64_t episodes = 0;
+        bool in_episode = false;
+    };
+
+    MotionStats();
+    explicit MotionStats(const EpisodeDetector::Options& episode_opts);
+
+    // Appends any episode this event closed to finished
+    void add(const MotionEvent& event, std::vector<MotionEpisode>& finished);
+    // Closes all open episodes (end of stream)
+    void finish(std::vector<MotionEpisode>& finished);
+
+    std::vector<RoiSummary> summary() const;
+    // True while any ROI has an open episode
+    bool inEpisode() const;
+
+private:
+    struct RoiStats {
+        explicit RoiStats(const EpisodeDetector::Options& opts);
+
+        RunningStats all;
+        RunningStats recent;
+        P2Quantile p50{0.5}, p95{0.95}, p99{0.99};
+        double max = 0.0;
+        uint64_t episodes = 0;
+        EpisodeDetector episode;
+    };
+
+    RoiStats& roi(int index);
+
+    EpisodeDetector::Options episode_opts_;
+    std::vector<RoiStats> rois_;
+};
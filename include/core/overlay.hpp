@@ -0,0 +1,11 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "../models/detection_result.hpp"
+
+// Draws ROIs (unless draw_roi is false), motion boxes and stats onto a copy
+// of result.frame. ROIs are labelled with roi_names[roi_index] when given.
+// out is reused across calls; returns false if the result has no frame.
+bool renderOverlay(const DetectionResult& result, cv::Mat& out,
+                   const std::vector<std::string>& roi_names = {}, bool draw_roi = true);
@@ -0,0 +1,112 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../queues/broadcast_channel.hpp"
+#include "../models/detection_result.hpp"
+
+/**
+ * Local HTTP MJPEG preview for nodes without a display. GET / lists the
+ * streams, GET /stream/<n> is a multipart/x-mixed-replace JPEG stream any
+ * browser or `ffplay` can show.
+ *
+ * One thread serves every client with non-blocking sockets. Each tick
+ * (opts.fps per second) a stream with viewers has its newest framed
+ * result drawn and JPEG-encoded once; all its clients share that buffer.
+ * A client still sending an older frame keeps only the newest one queued
+ * behind it, so slow clients drop frames and never hold up the others.
+ * A stream nobody watches has no subscription and costs nothing.
+ */
+class PreviewServer {
+public:
+    struct Options {
+        int port = 0;                            // TCP port, 0 = disabled
+        std::string bind_address = "127.0.0.1";
+        double fps = 5.0;                        // encoded frames/sec per stream
+        int jpeg_quality = 70;
+        int max_width = 1280;                    // downscale wider frames, 0 = never
+        size_t max_clients = 16;
+        std::vector<std::string> roi_names;      // overlay labels
+    };
+
+    struct Stats {
+        uint64_t connections = 0;
+        uint64_t frames_encoded = 0;
+        uint64_t frames_sent = 0;
+        uint64_t frames_dropped = 0;   // replaced before a slow client got them
+        double encode_ms = 0.0;        // total
+    };
+
+    // Called on the server thread with opts.fps when a stream's first viewer
+    // connects and with 0 when its last one leaves
+    using RateCallback = std::function<void(double fps)>;
+
+    explicit PreviewServer(const Options& opts);
+    ~PreviewServer();
+
+    PreviewServer(const PreviewServer&) = delete;
+    PreviewServer& operator=(const PreviewServer&) = delete;
+
+    // Call before start(); results is not owned. Returns the stream index.
+    size_t addStream(BroadcastChannel<DetectionResult>& results, RateCallback set_rate);
+
+    bool start();
+    void stop();
+
+    Stats stats() const;
+    int port() const { return bound_port_; }
+
+private:
+    using Chunk = std::shared_ptr<const std::string>;
+
+    struct Feed {
+        BroadcastChannel<DetectionResult>* results = nullptr;
+        RateCallback set_rate;
+        std::unique_ptr<BroadcastChannel<DetectionResult>::Subscriber> subscriber;
+        size_t viewers = 0;
+    };
+
+    struct Client {
+        int fd = -1;
+        int feed = -1;               // streaming from this feed, -1 = not (yet)
+        std::string request;
+        int64_t accepted_ms = 0;
+        Chunk current;               // being sent
+        size_t offset = 0;
+        Chunk next;                  // newest frame waiting behind current
+        bool close_after = false;    // one-shot reply: close once sent
+        bool closed = false;
+    };
+
+    void run();
+    void acceptClients();
+    void readRequest(Client& client);
+    void route(Client& client, const std::string& path);
+    void writeClient(Client& client);
+    void encodeFrames();
+    bool encode(const DetectionResult& result, Chunk& out);
+    void addViewer(Client& client, int feed);
+    void closeClient(Client& client);
+
+    Options opts_;
+    const Chunk stream_header_;
+    std::vector<Feed> feeds_;
+    std::vector<Client> clients_;   // server thread only
+    int listen_fd_ = -1;
+    int bound_port_ = 0;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    cv::Mat overlay_, scaled_;
+    std::vector<uchar> jpeg_;
+
+    std::atomic<uint64_t> connections_{0};
+    std::atomic<uint64_t> frames_encoded_{0};
+    std::atomic<uint64_t> frames_sent_{0};
+    std::atomic<uint64_t> frames_dropped_{0};
+    std::atomic<int64_t> encode_us_{0};
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "motion_detector.hpp"
+#include "../models/shm_frame_format.hpp"
+#include "../queues/frame_queue.hpp"
+
+/**
+ * Publishes analyzed frames into a POSIX shared-memory ring (see
+ * shm_frame_format.hpp) so other local processes can use the decoded
+ * pixels, the motion mask and the events without decoding the stream
+ * again. Readers attach with ShmFrameReader.
+ *
+ * The ring is created on the first publish(), sized for that frame; later
+ * frames that don't fit (a resolution change) are skipped and counted.
+ * Publishing is one copy of the frame and mask into the next slot and
+ * never waits for readers. A stale segment of the same name is replaced.
+ */
+class ShmFramePublisher {
+public:
+    struct Options {
+        std::string name;     // shm_open name, e.g. "/motion_0"
+        uint32_t slots = 4;   // a reader has slots - 1 frame times per frame
+    };
+
+    struct Stats {
+        uint64_t published = 0;
+        uint64_t skipped = 0;  // larger than the ring, or no ring
+    };
+
+    explicit ShmFramePublisher(const Options& opts);
+    // Marks the ring closed for readers, unmaps and unlinks it
+    ~ShmFramePublisher();
+
+    ShmFramePublisher(const ShmFramePublisher&) = delete;
+    ShmFramePublisher& operator=(const ShmFramePublisher&) = delete;
+
+    // Frame, mask and events of detector's last process() call. Call from
+    // the stream's processing thread only.
+    bool publish(const TimestampedFrame& tf, const MotionDetector& detector);
+
+    Stats stats() const;
+    const std::string& name() const { return opts_.name; }
+
+private:
+    bool create(size_t frame_bytes, size_t mask_bytes);
+    void close();
+
+    Options opts_;
+    char* base_ = nullptr;
+    size_t size_ = 0;
+    ShmRingHeader* header_ = nullptr;
+    ShmSlotHeader* slots_ = nullptr;
+    bool failed_ = false;  // create() failed; don't retry every frame
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> skipped_{0};
+};
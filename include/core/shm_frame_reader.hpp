@@ -0,0 +1,67 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../models/motion_event.hpp"
+#include "../models/shm_frame_format.hpp"
+
+/**
+ * One published frame. frame and mask are views into the shared ring,
+ * not copies, and stay readable only while ShmFrameReader::valid() holds:
+ * use them, then check valid() and drop the result if it fails.
+ */
+struct ShmFrame {
+    uint64_t index = 0;        // publish order in the ring
+    uint64_t frame_id = 0;
+    int64_t timestamp_ms = 0;
+    cv::Mat frame;             // read-only mapping; writes fault
+    cv::Mat mask;              // CV_8UC1 over mask_rect, processing scale
+    cv::Rect mask_rect;        // in frame coordinates
+    std::vector<MotionEvent> events;
+};
+
+/**
+ * Attaches to a ShmFramePublisher ring by name. Reading never blocks or
+ * writes the ring: a frame overwritten while it was being read is
+ * dropped and counted, never waited for.
+ */
+class ShmFrameReader {
+public:
+    ShmFrameReader() = default;
+    ~ShmFrameReader();
+
+    ShmFrameReader(const ShmFrameReader&) = delete;
+    ShmFrameReader& operator=(const ShmFrameReader&) = delete;
+
+    // False until the publisher has created the ring
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    uint64_t published() const;
+    // The publisher has stopped; frames still in the ring can be read
+    bool closed() const;
+
+    // Newest complete frame; next() continues after it
+    bool latest(ShmFrame& out);
+    // Next frame in publish order, starting at the newest on the first
+    // call. Frames overwritten before they could be read are skipped.
+    bool next(ShmFrame& out);
+    // True while out's slot still holds it
+    bool valid(const ShmFrame& out) const;
+
+    uint64_t skipped() const { return skipped_; }
+    const ShmRingHeader& header() const { return *header_; }
+
+private:
+    bool read(uint64_t index, ShmFrame& out) const;
+
+    char* base_ = nullptr;
+    size_t size_ = 0;
+    const ShmRingHeader* header_ = nullptr;
+    const ShmSlotHeader* slots_ = nullptr;
+    uint64_t cursor_ = 0;
+    bool started_ = false;
+    uint64_t skipped_ = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "motion_consumer.hpp"
+#include "video_capture.hpp"
+#include "worker_pool.hpp"
+#include "../queues/frame_queue.hpp"
+#include "../queues/mdcfg_queue.hpp"
+#include "../queues/mdresult_queue.hpp"
+
+/**
+ * Multi-stream engine: N sources share one WorkerPool for detection.
+ *
+ * Each stream keeps its own capture thread (decode blocks on I/O), FrameQueue,
+ * config queue, result channel and MotionDetector. Detection runs as pool tasks; a
+ * stream has at most one task scheduled at any time, so its frames are
+ * processed strictly in order while different streams run in parallel.
+ */
+class StreamEngine {
+public:
+    // 0 = one worker per hardware thread
+    explicit StreamEngine(size_t num_workers = 0);
+    ~StreamEngine();
+
+    // Must be called before start(). Returns the stream index.
+    size_t addStream(const std::string& source,
+                     const FrameQueue::Options& queue_opts = FrameQueue::Options(),
+                     const VideoCapture::Options& capture_opts = VideoCapture::Options());
+
+    bool start();
+    void stop();
+
+    size_t streamCount() const { return streams_.size(); }
+    size_t workerCount() const { return pool_.size(); }
+    MotionDetectionConfigQueue& configQueue(size_t stream);
+    // Subscribe here for the stream's results
+    MotionDetectionResultChannel& results(size_t stream);
+    const MotionConsumer& consumer(size_t stream) const;
+    const VideoCapture& capture(size_t stream) const;
+    FrameQueue& buffer(size_t stream);
+    // Call before start(); log is not owned
+    void setEventLog(size_t stream, EventLog* log);
+    // Only streams with a display rate > 0 attach frames to their results
+    void setDisplayRate(size_t stream, double fps);
+    // See MotionConsumer::setPreviewRate; safe to call while running
+    void setPreviewRate(size_t stream, double fps);
+    // Call before start(): label every stream's metrics with stream="<i>"
+    void enableMetrics();
+    // Call before start(); see MotionConsumer
+    void setClipRecorder(size_t stream, ClipRecorder* recorder);
+    void setShmPublisher(size_t stream, ShmFramePublisher* publisher);
+    void setCheckpointer(size_t stream, BackgroundCheckpointer* checkpointer);
+    // Also throttles the stream's capture analysis rate
+    void setLoadGovernor(size_t stream, LoadGovernor* governor,
+                         MotionConsumer::GovernorCallback callback = nullptr);
+    void setEpisodeOptions(size_t stream, const EpisodeDetector::Options& opts);
+    void setEpisodeCallback(size_t stream, MotionConsumer::EpisodeCallback callback);
+
+private:
+    struct Stream {
+        Stream(const std::string& source, const FrameQueue::Options& queue_opts,
+               const VideoCapture::Options& capture_opts);
+
+        std::unique_ptr<FrameQueue> buffer;
+        MotionDetectionConfigQueue config_queue;
+        MotionDetectionResultChannel results;
+        VideoCapture capture;
+        MotionConsumer consumer;
+        std::atomic<bool> scheduled{false};
+    };
+
+    void schedule(Stream& stream);
+    void run(Stream& stream);
+
+    // Frames handled per task before yielding the worker to other streams
+    static constexpr size_t kFramesPerTask = 4;
+
+    std::vector<std::unique_ptr<Stream>> streams_;
+    WorkerPool pool_;
+};
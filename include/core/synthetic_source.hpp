@@ -0,0 +1,64 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Deterministic synthetic video for load and accuracy testing.
+ *
+ * URI form: synthetic://WIDTHxHEIGHT@FPS?blobs=N&noise=SIGMA&seed=S&size=PX&speed=PX
+ * (every part optional; fps 0 = unpaced). Frame i shows `blobs` flat
+ * squares moving in straight lines and bouncing off the frame edges over a
+ * static texture, plus sensor noise. Positions are a closed-form function
+ * of (seed, i), so groundTruth(i) is exact and any frame can be rendered
+ * in any order.
+ *
+ * Noisy backgrounds are precomputed, so render() is one copy plus the
+ * blob fills; the capture side renders straight into pooled buffers.
+ */
+class SyntheticSource {
+public:
+    struct Spec {
+        int width = 1280;
+        int height = 720;
+        double fps = 30.0;
+        int blobs = 3;
+        double noise = 2.0;     // Gaussian sigma in gray levels
+        uint64_t seed = 1;
+        int blob_size = 0;      // side in px; 0 = height / 10
+        double speed = 0.0;     // px per frame; 0 = height / 120
+    };
+
+    // Returns false for a malformed URI (anything but the synthetic:// prefix
+    // is checked); unknown query keys are ignored
+    static bool parse(const std::string& uri, Spec& spec);
+    static bool isSyntheticUri(const std::string& uri);
+
+    explicit SyntheticSource(const Spec& spec);
+
+    const Spec& spec() const { return spec_; }
+    cv::Size size() const { return cv::Size(spec_.width, spec_.height); }
+
+    // Renders frame `index` into out (reallocated only if its geometry differs)
+    void render(uint64_t index, cv::Mat& out) const;
+    // Blob rectangles in frame `index`
+    std::vector<cv::Rect> groundTruth(uint64_t index) const;
+
+private:
+    struct Blob {
+        double x0, y0;          // position at frame 0
+        double vx, vy;          // px per frame
+        cv::Scalar color;
+    };
+
+    static double bounce(double start, double velocity, uint64_t index, double range);
+    cv::Rect blobRect(const Blob& b, uint64_t index) const;
+
+    static constexpr int kNoiseFrames = 4;
+
+    Spec spec_;
+    int blob_size_;
+    std::vector<Blob> blobs_;
+    std::vector<cv::Mat> backgrounds_;  // texture + noise, cycled
+};
@@ -1,30 +1,77 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <algorithm>
 #include <string>
 #include <thread>
 #include <atomic>
+#include <memory>
+#include "metrics.hpp"
+#include "synthetic_source.hpp"
 #include "../queues/frame_queue.hpp"
 
 class VideoCapture {
 public:
-    enum class SourceType { CAMERA, FILE, RTSP, HTTP };
+    enum class SourceType { CAMERA, FILE, RTSP, HTTP, SYNTHETIC };
+
+    /**
+     * Analysis-rate policy: every source frame is grab()bed to keep the
+     * stream position, but only frames picked for analysis are retrieve()d
+     * (color-converted and copied) and queued. analysis_fps, when set, wins
+     * over analyze_every and is measured against the source fps.
+     */
+    struct Options {
+        int analyze_every = 1;      // analyze every Nth frame
+        double analysis_fps = 0.0;  // target analyzed frames/sec, 0 = off
+        int decode_threads = -1;    // backend decode threads; -1 = backend default, 0 = all cores
+    };
+
+    // Counters since start(); times are wall-clock inside grab()/retrieve()
+    struct Stats {
+        uint64_t grabbed = 0;
+        uint64_t skipped = 0;       // grabbed but not retrieved
+        uint64_t retrieved = 0;
+        double grab_ms = 0.0;
+        double retrieve_ms = 0.0;
+    };
     
     VideoCapture(const std::string& source, FrameQueue& buffer);
+    VideoCapture(const std::string& source, FrameQueue& buffer, const Options& opts);
     ~VideoCapture();
     
     bool start();
     void stop();
     bool isRunning() const { return running_; }
+    Stats stats() const;
+    // Call before start(); labels are Prometheus labels, e.g. stream="0"
+    void enableMetrics(const std::string& labels);
+    // Analyze only 1 in n of the frames the Options pick; safe while running
+    void setAnalysisDivisor(int n) { analysis_divisor_ = std::max(1, n); }
+    // Generator behind a synthetic:// source (for ground truth), else nullptr
+    const SyntheticSource* synthetic() const { return synthetic_.get(); }
     
 private:
     void captureLoop();
+    bool open();
+    bool shouldAnalyze(uint64_t index, double stride);
     SourceType detectSourceType(const std::string& source);
     
     std::string source_;
     SourceType source_type_;
     FrameQueue& buffer_;
+    Options opts_;
     cv::VideoCapture cap_;
+    std::unique_ptr<SyntheticSource> synthetic_;
     std::thread capture_thread_;
     std::atomic<bool> running_{false};
     std::atomic<uint64_t> frame_count_{0};
-};
\ No newline at end of file
+    double next_analysis_ = 0.0;  // capture thread only
+    std::atomic<int> analysis_divisor_{1};
+    static constexpr size_t kPreallocatedFrames = 8;
+
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<uint64_t> retrieved_{0};
+    std::atomic<uint64_t> grab_ns_{0};
+    std::atomic<uint64_t> retrieve_ns_{0};
+    LatencyHistogram* grab_hist_ = nullptr;
+    LatencyHistogram* retrieve_hist_ = nullptr;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size work-stealing thread pool.
+ *
+ * Every worker owns a deque: tasks submitted from a worker go to the back of
+ * its own deque and are popped LIFO (cache-warm), idle workers steal from the
+ * front of other deques. Tasks submitted from outside the pool are spread
+ * round-robin over the workers.
+ */
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    // 0 = one worker per hardware thread
+    explicit WorkerPool(size_t num_workers = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // After shutdown() a task from outside the pool runs on the caller
+    // (and asserts in debug builds)
+    void submit(Task task);
+
+    /**
+     * Runs fn(0) .. fn(count - 1) on the pool and returns when all are done.
+     * The calling thread takes indices too, so this is safe from inside a
+     * pool task even when every other worker is busy.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    // Runs remaining tasks, then joins all workers
+    void shutdown();
+    size_t size() const { return workers_.size(); }
+
+private:
+    struct Worker {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+        std::thread thread;
+    };
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> next_worker_{0};
+    std::atomic<bool> stopping_{false};
+};
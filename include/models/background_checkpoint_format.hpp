@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+// On-disk layout of a background checkpoint (.mdbg), little-endian.
+//
+//   BackgroundCheckpointHeader
+//   BackgroundCheckpointModel[model_count]
+//   model 0: rows * cols * elem_size bytes, row-major (64-byte aligned)
+//   model 1: ...
+//
+// The writer fills a temp file and renames it over the old checkpoint, so
+// a reader sees either the previous checkpoint or the new one whole.
+// total_size guards against truncated files.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "background checkpoint format assumes a little-endian host"
+#endif
+
+constexpr char kCheckpointMagic[8] = {'M', 'D', 'B', 'G', 'C', 'K', 0, 0};
+constexpr uint32_t kCheckpointVersion = 1;
+constexpr uint32_t kCheckpointMaxModels = 1024;
+
+struct BackgroundCheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t model_count;
+    uint64_t total_size;        // file bytes
+    int64_t saved_unix_ms;
+    uint64_t frame_id;          // last frame folded into the models
+    int32_t frame_width, frame_height;
+    int32_t type;               // OpenCV type of every model
+    int32_t blur_kernel;
+    double process_scale;
+    int32_t pyramid_levels;
+    uint32_t reserved[15];
+};
+static_assert(sizeof(BackgroundCheckpointHeader) == 128, "BackgroundCheckpointHeader must be 128 bytes");
+
+struct BackgroundCheckpointModel {
+    uint32_t kind;              // BackgroundSnapshot::Kind
+    int32_t index;              // ROI index
+    int32_t rect[4];            // full-frame x, y, w, h
+    int32_t rows, cols;         // processing scale
+    uint64_t offset;            // from start of file
+    uint32_t reserved[6];
+};
+static_assert(sizeof(BackgroundCheckpointModel) == 64, "BackgroundCheckpointModel must be 64 bytes");
@@ -0,0 +1,43 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Copy of a MotionDetector's background models and the settings they
+ * depend on (see MotionDetector::snapshotBackground). A restored model is
+ * only used for an ROI whose frame size, rectangle and processing size
+ * still match.
+ */
+struct BackgroundSnapshot {
+    enum Kind : uint32_t {
+        ROI = 1,
+        FRAME = 2,   // full_frame_background model
+    };
+
+    struct Model {
+        Kind kind = ROI;
+        int index = 0;        // ROI index
+        cv::Rect rect;        // full-frame coordinates
+        cv::Mat background;   // CV_32FC1 or CV_16UC1 (8.8), processing scale
+    };
+
+    cv::Size frame_size;
+    int type = CV_32FC1;      // of every model
+    int blur_kernel = 0;
+    double process_scale = 1.0;
+    int pyramid_levels = 0;
+    uint64_t frame_id = 0;    // last frame folded into the models
+    int64_t saved_unix_ms = 0;
+    std::vector<Model> models;
+    // Memory the models wrap when loaded from a checkpoint (see
+    // loadBackgroundCheckpoint); keep it alive while they are in use
+    std::shared_ptr<void> storage;
+
+    size_t bytes() const {
+        size_t total = 0;
+        for (const auto& m : models) total += m.background.total() * m.background.elemSize();
+        return total;
+    }
+};
@@ -1,8 +1,15 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <vector>
 #include "motion_event.hpp"
 
+/**
+ * Compact per-frame result. `frame` shares the captured buffer (no copy)
+ * and is only attached for frames picked for display; overlays are drawn
+ * on demand with renderOverlay().
+ */
 struct DetectionResult {
-    cv::Mat visualization;
-    MotionEvent event;
-};
\ No newline at end of file
+    cv::Mat frame;
+    std::vector<MotionEvent> events;  // one per ROI
+    std::vector<cv::Rect> boxes;
+};
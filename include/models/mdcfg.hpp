@@ -1,11 +1,21 @@
 #pragma once
+#include <vector>
 #include "roi_config.hpp"
 
 struct MotionDetectorConfig {
     ROIConfig roi;
+    std::vector<ROIConfig> rois;  // replaces roi when not empty
     int threshold = 25;
     int blur_kernel = 21;
     int min_contour_area = 100;
     double learning_rate = 0.01;
     bool reset_background = false;
+    double process_scale = 1.0;  // see MotionDetector::Config
+    int pyramid_levels = 0;
+    bool refine = false;
+    int tile_size = 16;  // change-gating tile, 0 = off
+    bool fixed_point = false;  // 8.8 uint16 background instead of float
+    bool full_frame_background = false;  // seed ROI changes, no re-learning
+    int strips = 1;  // parallel horizontal strips per frame
+    bool visualize = true;  // false: results carry no frame (see MotionDetector::Config)
 };
\ No newline at end of file
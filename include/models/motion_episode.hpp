@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * One debounced stretch of motion in an ROI: from the first frame above
+ * the start threshold to the last frame above the release threshold
+ * before a quiet gap.
+ */
+struct MotionEpisode {
+    int roi_index = 0;
+    uint64_t start_frame = 0;
+    uint64_t end_frame = 0;
+    uint64_t peak_frame = 0;
+    int64_t start_ms = 0;
+    int64_t end_ms = 0;
+    int64_t peak_ms = 0;
+    double peak_score = 0.0;
+    double mean_score = 0.0;
+    uint64_t frames = 0;       // frames reported from start to end
+
+    int64_t durationMs() const { return end_ms - start_ms; }
+};
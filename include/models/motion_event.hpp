@@ -8,4 +8,5 @@ struct MotionEvent {
     int contour_count;
     cv::Rect largest_bbox;
     cv::Rect roi_used;
+    int roi_index = 0;  // position in the detector's ROI list
 };
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+// On-disk layout of the binary motion log (.mdlog), little-endian.
+//
+//   MotionLogHeader
+//   MotionLogColumn[column_count]
+//   column 0: capacity * elem_size bytes (64-byte aligned)
+//   column 1: ...
+//
+// Each column is a fixed-width array reserved for `capacity` rows, so a
+// reader can map it directly (C++ MotionLogReader, numpy.memmap). Only the
+// first `count` rows are valid; the writer bumps count on every flush.
+// Columns are looked up by name, so new ones can be added without breaking
+// older readers.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "motion log format assumes a little-endian host"
+#endif
+
+constexpr char kMotionLogMagic[8] = {'M', 'D', 'L', 'O', 'G', 0, 0, 0};
+constexpr uint32_t kMotionLogVersion = 1;
+
+struct MotionLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t capacity;
+    uint64_t count;
+    uint32_t header_size;   // header + column table, bytes
+    uint32_t reserved[7];
+};
+static_assert(sizeof(MotionLogHeader) == 64, "MotionLogHeader must be 64 bytes");
+
+struct MotionLogColumn {
+    char name[16];          // NUL-padded
+    char dtype[4];          // numpy type string, e.g. "<i8"
+    uint32_t elem_size;
+    uint64_t offset;        // from start of file
+};
+static_assert(sizeof(MotionLogColumn) == 32, "MotionLogColumn must be 32 bytes");
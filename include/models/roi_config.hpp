@@ -1,11 +1,16 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <string>
 
 struct ROIConfig {
+    std::string name;           // Label for overlays; events carry the index
     float center_x = 0.5f;      // Center position (0.0 - 1.0)
     float center_y = 0.6f;
     float width_ratio = 0.3f;   // ROI is 30% of frame width
     float height_ratio = 0.8f;  // ROI is 50% of frame height
+    // Per-ROI overrides; -1 = use the detector-wide value
+    int threshold = -1;
+    int min_contour_area = -1;
     
     cv::Rect toRect(int frame_width, int frame_height) const {
         int roi_w = static_cast<int>(frame_width * width_ratio);
@@ -19,4 +24,9 @@ struct ROIConfig {
         
         return cv::Rect(roi_x, roi_y, roi_w, roi_h);
     }
+
+    bool sameGeometry(const ROIConfig& other) const {
+        return center_x == other.center_x && center_y == other.center_y &&
+               width_ratio == other.width_ratio && height_ratio == other.height_ratio;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Layout of a per-stream shared-memory frame ring (POSIX shm_open name,
+// e.g. "/motion_0"), host byte order:
+//
+//   ShmRingHeader
+//   ShmSlotHeader[slot_count]     (kShmAlign apart)
+//   slot 0 data: frame pixels, then the motion mask (each kShmAlign-aligned)
+//   slot 1 data: ...
+//
+// Frame n goes to slot n % slot_count. Each slot is a seqlock: its seq is
+// odd while the publisher writes it and 2 * n + 2 once frame n is
+// complete. A reader takes what it needs while seq stays at that value
+// and checks it again afterwards; on a mismatch the slot was reused
+// meanwhile and the read is discarded. Readers never write to the ring.
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory ring needs address-free 64-bit atomics");
+
+constexpr char kShmRingMagic[8] = {'M', 'D', 'S', 'H', 'M', 0, 0, 0};
+constexpr uint32_t kShmRingVersion = 1;
+constexpr size_t kShmAlign = 64;
+constexpr uint32_t kShmMaxEvents = 16;  // per frame; more ROIs are cut off
+
+enum ShmRingState : uint32_t {
+    SHM_RING_LIVE = 1,
+    SHM_RING_CLOSED = 2,   // publisher stopped; no more frames
+};
+
+struct ShmRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_count;
+    uint64_t total_size;          // bytes mapped
+    uint64_t frame_capacity;      // bytes per slot for pixels
+    uint64_t mask_capacity;       // bytes per slot for the mask
+    std::atomic<uint64_t> published;  // frames completed so far
+    std::atomic<uint32_t> state;
+    uint32_t reserved[3];
+};
+static_assert(sizeof(ShmRingHeader) == 64, "ShmRingHeader must be 64 bytes");
+
+// MotionEvent without OpenCV types; rects are full-frame x, y, w, h
+struct ShmMotionEvent {
+    uint64_t frame_id;
+    int64_t timestamp_ms;
+    double motion_score;
+    int32_t contour_count;
+    int32_t roi_index;
+    int32_t largest_bbox[4];
+    int32_t roi[4];
+};
+static_assert(sizeof(ShmMotionEvent) == 64, "ShmMotionEvent must be 64 bytes");
+
+struct ShmSlotHeader {
+    std::atomic<uint64_t> seq;
+    uint64_t frame_id;
+    int64_t timestamp_ms;
+    uint64_t frame_offset;        // from start of mapping
+    uint64_t mask_offset;
+    int32_t width, height;        // frame
+    int32_t type;                 // OpenCV type, e.g. CV_8UC3
+    int32_t step;                 // bytes per frame row
+    // Mask: CV_8UC1 at processing scale, covering mask_rect of the frame
+    // (the union of the ROIs); 255 where motion was found after dilation
+    int32_t mask_width, mask_height;
+    int32_t mask_rect[4];
+    uint32_t event_count;
+    uint32_t reserved[11];
+    ShmMotionEvent events[kShmMaxEvents];
+};
+static_assert(sizeof(ShmSlotHeader) % kShmAlign == 0, "ShmSlotHeader must be a multiple of 64 bytes");
+
+constexpr uint64_t shmAlign(uint64_t n) {
+    return (n + kShmAlign - 1) / kShmAlign * kShmAlign;
+}
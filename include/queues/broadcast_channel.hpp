@@ -0,0 +1,226 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Bounded single-publisher, multi-subscriber broadcast ring.
+ *
+ * publish() wraps each item in a shared_ptr and stores it in the next of
+ * `capacity` slots, overwriting (and releasing) the oldest. Subscribers
+ * hold their own cursor and read shared references, so payloads are never
+ * copied and a subscriber that falls behind only loses items itself: the
+ * publisher never waits for anyone, and nobody waits for a slow reader.
+ *
+ * Slots are versioned like a seqlock: a reader checks the slot's sequence
+ * before and after taking the reference and retries if it was overwritten
+ * in between. The shared_ptr itself is read and written with the atomic
+ * shared_ptr functions.
+ *
+ * A slot keeps its item alive until it is overwritten, even after every
+ * subscriber has read it, so up to `capacity` items (and whatever they
+ * share, such as pooled frame buffers) stay referenced.
+ *
+ * claim() + publish() fill the item in place instead: the item about to
+ * be overwritten is handed back for reuse when no subscriber still holds
+ * it, so in steady state neither the item, its shared_ptr control block
+ * nor (when assigned rather than replaced) its members' buffers are
+ * reallocated.
+ *
+ * Subscribers must be destroyed before the channel.
+ */
+template<typename T>
+class BroadcastChannel {
+public:
+    using Ptr = std::shared_ptr<const T>;
+
+    enum class Policy {
+        ALL,     // every item in order; items overwritten before being read are dropped
+        LATEST   // each read returns the newest item and skips the rest
+    };
+
+    class Subscriber {
+    public:
+        ~Subscriber() { channel_.unregister(this); }
+
+        Subscriber(const Subscriber&) = delete;
+        Subscriber& operator=(const Subscriber&) = delete;
+
+        // Next item, or nullptr when caught up. Not thread-safe: one
+        // thread reads through a Subscriber.
+        Ptr tryNext() { return channel_.read(*this); }
+        // Waits up to timeout_ms for an item
+        Ptr next(int timeout_ms) {
+            if (Ptr item = tryNext()) return item;
+            channel_.waitFor(*this, timeout_ms);
+            return tryNext();
+        }
+
+        uint64_t received() const { return received_.load(std::memory_order_relaxed); }
+        // Items skipped because they were overwritten, or by LATEST / max_lag
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+        // Items published but not yet read
+        uint64_t lag() const {
+            uint64_t head = channel_.head_.load(std::memory_order_acquire);
+            uint64_t cursor = cursor_.load(std::memory_order_relaxed);
+            return head > cursor ? head - cursor : 0;
+        }
+
+    private:
+        friend class BroadcastChannel;
+        Subscriber(BroadcastChannel& channel, Policy policy, size_t max_lag, uint64_t cursor)
+            : channel_(channel), policy_(policy), max_lag_(max_lag), cursor_(cursor) {}
+
+        BroadcastChannel& channel_;
+        const Policy policy_;
+        const size_t max_lag_;
+        std::atomic<uint64_t> cursor_;   // next sequence to read
+        std::atomic<uint64_t> received_{0};
+        std::atomic<uint64_t> dropped_{0};
+    };
+
+    // Capacity is at least 2; one slot is kept free for the publisher
+    explicit BroadcastChannel(size_t capacity = 16)
+        : capacity_(std::max<size_t>(2, capacity))
+        , slots_(new Slot[capacity_]) {}
+
+    BroadcastChannel(const BroadcastChannel&) = delete;
+    BroadcastChannel& operator=(const BroadcastChannel&) = delete;
+
+    /**
+     * New subscriber starting at the next published item. With max_lag > 0
+     * an ALL subscriber more than max_lag items behind skips ahead to the
+     * newest max_lag.
+     */
+    std::unique_ptr<Subscriber> subscribe(Policy policy = Policy::ALL, size_t max_lag = 0) {
+        std::unique_ptr<Subscriber> sub(
+            new Subscriber(*this, policy, max_lag, head_.load(std::memory_order_acquire)));
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        subscribers_.push_back(sub.get());
+        return sub;
+    }
+
+    // Single publisher; never blocks on subscribers
+    void publish(T&& item) {
+        claim() = std::move(item);
+        publish();
+    }
+
+    /**
+     * Item the next publish() makes visible, the publisher's to fill. It is
+     * the overwritten slot's previous item if no subscriber holds that any
+     * more (reused as is: assign every field), else a new one.
+     */
+    T& claim() {
+        if (claimed_) return *claimed_;
+        Slot& slot = slots_[head_.load(std::memory_order_relaxed) % capacity_];
+        // Only a subscriber with a stale head still looks at this slot;
+        // it sees kWriting (or nullptr followed by kWriting) and retries
+        slot.seq.store(kWriting, std::memory_order_relaxed);
+        std::shared_ptr<T> old = std::const_pointer_cast<T>(
+            std::atomic_exchange(&slot.item, Ptr()));
+        if (old && old.use_count() == 1) {
+            // Pairs with the release of the last subscriber's reference
+            std::atomic_thread_fence(std::memory_order_acquire);
+            claimed_ = std::move(old);
+        } else {
+            claimed_ = std::make_shared<T>();
+        }
+        return *claimed_;
+    }
+
+    // Publishes the claimed item
+    void publish() {
+        claim();
+        uint64_t seq = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[seq % capacity_];
+        slot.seq.store(kWriting, std::memory_order_relaxed);
+        std::atomic_store(&slot.item, Ptr(std::move(claimed_)));
+        slot.seq.store(seq, std::memory_order_release);
+        head_.store(seq + 1);
+        if (waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            wait_cv_.notify_all();
+        }
+    }
+
+    uint64_t published() const { return head_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+
+    size_t subscriberCount() const {
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        return subscribers_.size();
+    }
+
+    // Lag of the slowest subscriber, capped at what the ring still holds
+    size_t maxLag() const {
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        uint64_t lag = 0;
+        for (const Subscriber* sub : subscribers_) lag = std::max(lag, sub->lag());
+        return static_cast<size_t>(std::min<uint64_t>(lag, capacity_ - 1));
+    }
+
+private:
+    static constexpr uint64_t kWriting = UINT64_MAX;
+
+    struct Slot {
+        std::atomic<uint64_t> seq{kWriting};
+        Ptr item;
+    };
+
+    Ptr read(Subscriber& sub) {
+        // The slot the publisher writes next is never a valid target
+        uint64_t window = capacity_ - 1;
+        if (sub.max_lag_ > 0) window = std::min<uint64_t>(window, sub.max_lag_);
+        while (true) {
+            uint64_t head = head_.load(std::memory_order_acquire);
+            uint64_t cursor = sub.cursor_.load(std::memory_order_relaxed);
+            if (cursor >= head) return nullptr;
+
+            uint64_t target = sub.policy_ == Policy::LATEST ? head - 1 : cursor;
+            if (head - target > window) target = head - window;
+            Slot& slot = slots_[target % capacity_];
+            if (slot.seq.load(std::memory_order_acquire) != target) continue;
+            Ptr item = std::atomic_load(&slot.item);
+            if (slot.seq.load(std::memory_order_acquire) != target) continue;  // overwritten
+
+            sub.dropped_.fetch_add(target - cursor, std::memory_order_relaxed);
+            sub.received_.fetch_add(1, std::memory_order_relaxed);
+            sub.cursor_.store(target + 1, std::memory_order_relaxed);
+            return item;
+        }
+    }
+
+    void waitFor(const Subscriber& sub, int timeout_ms) {
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        ++waiters_;
+        wait_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] {
+            return head_.load() > sub.cursor_.load(std::memory_order_relaxed);
+        });
+        --waiters_;
+    }
+
+    void unregister(const Subscriber* sub) {
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        subscribers_.erase(std::remove(subscribers_.begin(), subscribers_.end(), sub),
+                           subscribers_.end());
+    }
+
+    const size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::shared_ptr<T> claimed_;  // publisher only
+    alignas(64) std::atomic<uint64_t> head_{0};  // next sequence to publish
+
+    std::atomic<int> waiters_{0};
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+
+    mutable std::mutex subscribers_mutex_;
+    std::vector<Subscriber*> subscribers_;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/**
+ * Recycling pool of frame buffers.
+ *
+ * The pool keeps one reference to every buffer it hands out. A buffer is
+ * free again once every other cv::Mat referencing it is gone, i.e. when its
+ * refcount drops back to 1, so consumers return buffers simply by releasing
+ * their Mats (popping a TimestampedFrame and letting it go out of scope).
+ */
+class FramePool {
+public:
+    explicit FramePool(size_t capacity = 32);
+
+    // A buffer of the given geometry that nobody else references. Allocates
+    // when no free buffer fits; an empty size returns an empty Mat.
+    cv::Mat acquire(cv::Size size, int type);
+    // Allocates buffers up front (up to capacity) so a producer with known
+    // geometry never allocates on its hot path
+    void preallocate(cv::Size size, int type, size_t count);
+    // Room for n more buffers, for consumers that keep frames past the
+    // queue (e.g. results that share them)
+    void addCapacity(size_t n);
+
+    // Buffers allocated since construction (pool misses)
+    uint64_t allocations() const { return allocations_; }
+    uint64_t reuses() const { return reuses_; }
+    size_t size() const;
+
+private:
+    static bool isFree(const cv::Mat& m);
+
+    size_t capacity_;
+    std::vector<cv::Mat> buffers_;
+    mutable std::mutex mutex_;
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<uint64_t> reuses_{0};
+};
@@ -1,28 +1,94 @@
 #pragma once
 #include <opencv2/opencv.hpp>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
 #include <atomic>
-#include "queues/thread_queue.hpp"
+#include <functional>
+#include <memory>
+#include <optional>
+#include "queues/frame_pool.hpp"
 
 struct TimestampedFrame {
   cv::Mat frame;
   int64_t timestamp_ms;
   uint64_t frame_id;
+  int64_t capture_ns = 0;  // metricsNow() at push, 0 when metrics are off
 };
 
-class FrameQueue: public ThreadQueue<TimestampedFrame> {
+// What push() does when the queue is full
+enum class OverflowPolicy {
+  BLOCK,        // wait for space (stalls the producer)
+  DROP_OLDEST,  // evict the oldest queued frame
+  DROP_NEWEST,  // discard the incoming frame
+  LATEST_ONLY   // drop-oldest on push, pop() skips to the newest frame
+};
+
+/**
+ * Bounded frame queue between a capture thread and its consumer.
+ *
+ * The interface plus what every implementation shares: policy, capacity,
+ * drop counters, the frame pool and the push listener. create() picks
+ * MutexFrameQueue or LockFreeFrameQueue.
+ */
+class FrameQueue {
   public:
-    explicit FrameQueue(size_t max_size = 30);
-    bool push(TimestampedFrame&& frame) override;
-    bool pop(TimestampedFrame& frame, int timeout_ms = 100);
-    void shutdown();
-    size_t size() const;
+    struct Options {
+      size_t max_size = 30;
+      OverflowPolicy policy = OverflowPolicy::BLOCK;
+      bool lock_free = false;  // LockFreeFrameQueue instead of MutexFrameQueue
+    };
+
+    struct Stats {
+      uint64_t pushed = 0;
+      uint64_t popped = 0;
+      uint64_t dropped_oldest = 0;
+      uint64_t dropped_newest = 0;
+      uint64_t dropped_stale = 0;  // skipped by LATEST_ONLY pops
+    };
+
+    static std::unique_ptr<FrameQueue> create(const Options& opts);
+
+    virtual ~FrameQueue() = default;
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    // Applies the overflow policy when full; false if the frame was
+    // dropped or the queue is shut down
+    virtual bool push(TimestampedFrame&& frame) = 0;
+    // Waits up to timeout_ms; the newest frame under LATEST_ONLY
+    virtual bool pop(TimestampedFrame& frame, int timeout_ms = 100) = 0;
+    // Wakes and fails waiting calls; frames still queued can be popped
+    virtual void shutdown() = 0;
+    virtual size_t size() const = 0;
+
+    virtual std::optional<TimestampedFrame> tryPop() = 0;
+    // Newest queued frame, discarding older ones
+    virtual std::optional<TimestampedFrame> tryPopLatest() = 0;
+    virtual bool empty() const = 0;
+
+    OverflowPolicy policy() const { return policy_; }
+    size_t capacity() const { return max_size_; }
+    Stats stats() const;
+
+    // Producer side: buffers are recycled once consumers release popped frames
+    FramePool& pool() { return pool_; }
+
+    // Invoked after every successful push, outside any queue lock
+    void setPushListener(std::function<void()> listener);
+
+  protected:
+    FrameQueue(size_t max_size, OverflowPolicy policy);
+
+    void notifyPushed() { if (push_listener_) push_listener_(); }
 
-  private:
-    std::condition_variable cv_not_empty_;
-    std::condition_variable cv_not_full_;
     size_t max_size_;
+    OverflowPolicy policy_;
     std::atomic<bool> shutdown_{false};
-};
\ No newline at end of file
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> popped_{0};
+    std::atomic<uint64_t> dropped_oldest_{0};
+    std::atomic<uint64_t> dropped_newest_{0};
+    std::atomic<uint64_t> dropped_stale_{0};
+
+  private:
+    FramePool pool_;
+    std::function<void()> push_listener_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include "queues/frame_queue.hpp"
+#include "queues/bounded_ring.hpp"
+
+/**
+ * FrameQueue backed by a lock-free BoundedRing.
+ *
+ * Neither push() nor pop() takes a lock; waiting (BLOCK on a full ring,
+ * pop() on an empty one) spins briefly, then backs off with short sleeps.
+ * DROP_OLDEST/LATEST_ONLY evict from the producer side by popping the
+ * oldest slot, which the ring allows concurrently with the consumer.
+ * popLatest() hands out the freshest frame regardless of policy.
+ */
+class LockFreeFrameQueue : public FrameQueue {
+  public:
+    explicit LockFreeFrameQueue(size_t max_size = 32,
+                                OverflowPolicy policy = OverflowPolicy::LATEST_ONLY);
+
+    bool push(TimestampedFrame&& frame) override;
+    bool pop(TimestampedFrame& frame, int timeout_ms = 100) override;
+    void shutdown() override;
+    size_t size() const override;
+
+    // Newest queued frame, discarding older ones; never waits
+    bool popLatest(TimestampedFrame& frame);
+
+    std::optional<TimestampedFrame> tryPop() override;
+    std::optional<TimestampedFrame> tryPopLatest() override;
+    bool empty() const override;
+
+  private:
+    bool popNow(TimestampedFrame& frame);
+
+    BoundedRing<TimestampedFrame> ring_;
+};
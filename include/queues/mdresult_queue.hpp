@@ -1,4 +1,13 @@
-#include "thread_queue.hpp"
+#pragma once
+#include "broadcast_channel.hpp"
 #include "../models/detection_result.hpp"
 
-class MotionDetectionResultQueue : public ThreadQueue<DetectionResult> {};
\ No newline at end of file
+// Detection results fanned out to display, recording and export subscribers.
+// Results that carry a frame pin its capture buffer while in the ring; see
+// MotionConsumer, which sizes the capture FramePool for that.
+class MotionDetectionResultChannel : public BroadcastChannel<DetectionResult> {
+public:
+    static constexpr size_t kDefaultCapacity = 16;
+    explicit MotionDetectionResultChannel(size_t capacity = kDefaultCapacity)
+        : BroadcastChannel<DetectionResult>(capacity) {}
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include <condition_variable>
+#include <queue>
+#include <mutex>
+#include "queues/frame_queue.hpp"
+
+/**
+ * FrameQueue guarded by a mutex, with condition variables for BLOCK on a
+ * full queue and pop() on an empty one.
+ */
+class MutexFrameQueue : public FrameQueue {
+  public:
+    explicit MutexFrameQueue(size_t max_size = 30,
+                             OverflowPolicy policy = OverflowPolicy::BLOCK);
+
+    bool push(TimestampedFrame&& frame) override;
+    bool pop(TimestampedFrame& frame, int timeout_ms = 100) override;
+    void shutdown() override;
+    size_t size() const override;
+
+    std::optional<TimestampedFrame> tryPop() override;
+    std::optional<TimestampedFrame> tryPopLatest() override;
+    bool empty() const override;
+
+  private:
+    // Caller holds mutex_ and queue_ is not empty
+    void popLocked(TimestampedFrame& frame, bool latest);
+
+    std::queue<TimestampedFrame> queue_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_not_empty_;
+    std::condition_variable cv_not_full_;
+};
@@ -6,13 +6,15 @@
 template<typename T>
 class ThreadQueue {
 public:
+    virtual ~ThreadQueue() = default;
+
     virtual bool push(T&& item) {
         std::lock_guard<std::mutex> lock(mutex_);
         queue_.push(std::move(item));
         return true;
     }
     
-    std::optional<T> tryPop() {
+    virtual std::optional<T> tryPop() {
         std::lock_guard<std::mutex> lock(mutex_);
         if (queue_.empty()) return std::nullopt;
         
@@ -22,7 +24,7 @@ public:
     }
     
     // Get latest, discard old (useful for config updates)
-    std::optional<T> tryPopLatest() {
+    virtual std::optional<T> tryPopLatest() {
         std::lock_guard<std::mutex> lock(mutex_);
         if (queue_.empty()) return std::nullopt;
         
@@ -31,10 +33,15 @@ public:
         return item;
     }
     
-    bool empty() const {
+    virtual bool empty() const {
         std::lock_guard<std::mutex> lock(mutex_);
         return queue_.empty();
     }
+
+    virtual size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
     
 protected: 
     std::queue<T> queue_;
@@ -8,11 +8,46 @@ import matplotlib.pyplot as plt
 from scipy import signal, stats
 from pathlib import Path
 import argparse
+import struct
 
 
-def load_data(csv_path: str) -> pd.DataFrame:
-    """Load motion data from CSV."""
-    df = pd.read_csv(csv_path)
+MDLOG_MAGIC = b'MDLOG\0\0\0'
+MDLOG_VERSION = 1
+MDLOG_HEADER = struct.Struct('<8sIIQQI28x')   # MotionLogHeader, 64 bytes
+MDLOG_COLUMN = struct.Struct('<16s4sIQ')      # MotionLogColumn, 32 bytes
+
+
+def load_binary(path: str) -> dict:
+    """Map the columns of a binary motion log (.mdlog) without copying.
+
+    Returns {column name: numpy.memmap} holding the first `count` rows.
+    """
+    with open(path, 'rb') as f:
+        magic, version, ncols, capacity, count, header_size = MDLOG_HEADER.unpack(
+            f.read(MDLOG_HEADER.size))
+        if magic != MDLOG_MAGIC or version > MDLOG_VERSION:
+            raise ValueError(f'{path}: not a supported motion log')
+        table = f.read(ncols * MDLOG_COLUMN.size)
+
+    columns = {}
+    for i in range(ncols):
+        name, dtype, _, offset = MDLOG_COLUMN.unpack_from(table, i * MDLOG_COLUMN.size)
+        name = name.rstrip(b'\0').decode()
+        dtype = dtype.rstrip(b'\0').decode()
+        columns[name] = np.memmap(path, dtype=dtype, mode='r', offset=offset,
+                                  shape=(min(count, capacity),))
+    return columns
+
+
+def load_segment(path: str) -> pd.DataFrame:
+    if path.endswith('.mdlog'):
+        return pd.DataFrame(load_binary(path))
+    return pd.read_csv(path)
+
+
+def load_data(csv_paths: list) -> pd.DataFrame:
+    """Load motion data from one or more rotated segments (CSV or .mdlog), in order."""
+    df = pd.concat([load_segment(p) for p in csv_paths], ignore_index=True)
     df['time_sec'] = (df['timestamp_ms'] - df['timestamp_ms'].iloc[0]) / 1000
     return df
 
@@ -148,14 +183,19 @@ def generate_report(df: pd.DataFrame, stats: dict, output_path: Path):
 
 def main():
     parser = argparse.ArgumentParser(description='Analyze motion detection data')
-    parser.add_argument('csv_file', help='Input CSV file from motion detector')
+    parser.add_argument('csv_file', nargs='+',
+                        help='Input CSV or .mdlog file(s) from motion detector, oldest segment first')
     parser.add_argument('-o', '--output', default='analysis', help='Output directory')
+    parser.add_argument('--roi', type=int, default=0,
+                        help='ROI index to analyze in multi-ROI logs (default 0)')
     args = parser.parse_args()
     
     output_dir = Path(args.output)
     
-    print(f"Loading data from {args.csv_file}...")
+    print(f"Loading data from {', '.join(args.csv_file)}...")
     df = load_data(args.csv_file)
+    if 'roi_index' in df:
+        df = df[df['roi_index'] == args.roi].reset_index(drop=True)
     
     print("Computing statistics...")
     stats = compute_statistics(df)
@@ -0,0 +1,237 @@
+#include "core/background_checkpoint.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t kModelAlign = 64;
+
+uint64_t alignUp(uint64_t v, uint64_t a) {
+    return (v + a - 1) / a * a;
+}
+
+size_t modelBytes(int rows, int cols, int type) {
+    return static_cast<size_t>(rows) * cols * CV_ELEM_SIZE(type);
+}
+
+}  // namespace
+
+bool saveBackgroundCheckpoint(const std::string& path, const BackgroundSnapshot& snapshot) {
+    BackgroundCheckpointHeader header{};
+    std::memcpy(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+    header.version = kCheckpointVersion;
+    header.model_count = static_cast<uint32_t>(snapshot.models.size());
+    header.saved_unix_ms = snapshot.saved_unix_ms;
+    header.frame_id = snapshot.frame_id;
+    header.frame_width = snapshot.frame_size.width;
+    header.frame_height = snapshot.frame_size.height;
+    header.type = snapshot.type;
+    header.blur_kernel = snapshot.blur_kernel;
+    header.process_scale = snapshot.process_scale;
+    header.pyramid_levels = snapshot.pyramid_levels;
+
+    std::vector<BackgroundCheckpointModel> table(snapshot.models.size());
+    uint64_t offset = alignUp(sizeof(header) + table.size() * sizeof(BackgroundCheckpointModel),
+                              kModelAlign);
+    for (size_t i = 0; i < table.size(); ++i) {
+        const BackgroundSnapshot::Model& m = snapshot.models[i];
+        if (m.background.type() != snapshot.type || !m.background.isContinuous()) return false;
+        BackgroundCheckpointModel& t = table[i];
+        t.kind = m.kind;
+        t.index = m.index;
+        const int32_t rect[4] = {m.rect.x, m.rect.y, m.rect.width, m.rect.height};
+        std::memcpy(t.rect, rect, sizeof(rect));
+        t.rows = m.background.rows;
+        t.cols = m.background.cols;
+        t.offset = offset;
+        offset = alignUp(offset + modelBytes(t.rows, t.cols, snapshot.type), kModelAlign);
+    }
+    header.total_size = offset;
+
+    const std::string tmp = path + ".tmp";
+    FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) return false;
+    static const char kZeros[kModelAlign] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (table.empty() ||
+               std::fwrite(table.data(), sizeof(table[0]), table.size(), file) == table.size());
+    uint64_t written = sizeof(header) + table.size() * sizeof(BackgroundCheckpointModel);
+    for (size_t i = 0; ok && i < table.size(); ++i) {
+        ok = std::fwrite(kZeros, 1, table[i].offset - written, file) == table[i].offset - written;
+        const cv::Mat& bg = snapshot.models[i].background;
+        const size_t bytes = bg.total() * bg.elemSize();
+        ok = ok && std::fwrite(bg.data, 1, bytes, file) == bytes;
+        written = table[i].offset + bytes;
+    }
+    ok = ok && std::fwrite(kZeros, 1, header.total_size - written, file) == header.total_size - written;
+    // On disk before the rename, so a crash leaves the old checkpoint or the new one
+    ok = ok && std::fflush(file) == 0 && ::fsync(::fileno(file)) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) std::remove(tmp.c_str());
+    return ok;
+}
+
+/**
+ * Maps the file copy-on-write and wraps each model in place, so loading
+ * costs the same for any model size: pages are read in as the detector
+ * first touches them and copied only when it updates them.
+ */
+bool loadBackgroundCheckpoint(const std::string& path, BackgroundSnapshot& snapshot) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BackgroundCheckpointHeader)) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    std::shared_ptr<void> storage(mapped, [size](void* p) { ::munmap(p, size); });
+
+    const char* base = static_cast<const char*>(mapped);
+    const BackgroundCheckpointHeader& header = *reinterpret_cast<const BackgroundCheckpointHeader*>(base);
+    bool ok = std::memcmp(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) == 0 &&
+              header.version == kCheckpointVersion && header.total_size == size &&
+              header.model_count <= kCheckpointMaxModels &&
+              sizeof(header) + header.model_count * sizeof(BackgroundCheckpointModel) <= size &&
+              (header.type == CV_32FC1 || header.type == CV_16UC1) &&
+              header.frame_width > 0 && header.frame_height > 0;
+    if (!ok) return false;
+
+    const BackgroundCheckpointModel* table =
+        reinterpret_cast<const BackgroundCheckpointModel*>(base + sizeof(header));
+    std::vector<BackgroundSnapshot::Model> models(header.model_count);
+    for (size_t i = 0; i < models.size(); ++i) {
+        const BackgroundCheckpointModel& t = table[i];
+        ok = (t.kind == BackgroundSnapshot::ROI || t.kind == BackgroundSnapshot::FRAME) &&
+             t.rows > 0 && t.cols > 0 && t.rows <= header.frame_height &&
+             t.cols <= header.frame_width && t.offset % kModelAlign == 0 &&
+             t.offset + modelBytes(t.rows, t.cols, header.type) <= size;
+        if (!ok) return false;
+        BackgroundSnapshot::Model& m = models[i];
+        m.kind = static_cast<BackgroundSnapshot::Kind>(t.kind);
+        m.index = t.index;
+        m.rect = cv::Rect(t.rect[0], t.rect[1], t.rect[2], t.rect[3]);
+        m.background = cv::Mat(t.rows, t.cols, header.type, static_cast<char*>(mapped) + t.offset);
+    }
+    snapshot.frame_size = cv::Size(header.frame_width, header.frame_height);
+    snapshot.type = header.type;
+    snapshot.blur_kernel = header.blur_kernel;
+    snapshot.process_scale = header.process_scale;
+    snapshot.pyramid_levels = header.pyramid_levels;
+    snapshot.frame_id = header.frame_id;
+    snapshot.saved_unix_ms = header.saved_unix_ms;
+    snapshot.models = std::move(models);
+    snapshot.storage = std::move(storage);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+BackgroundCheckpointer::BackgroundCheckpointer(const Options& opts) : opts_(opts) {}
+
+BackgroundCheckpointer::~BackgroundCheckpointer() {
+    stop();
+}
+
+bool BackgroundCheckpointer::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) return true;
+    running_ = true;
+    next_due_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(opts_.interval_ms);
+    thread_ = std::thread(&BackgroundCheckpointer::run, this);
+    return true;
+}
+
+void BackgroundCheckpointer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+bool BackgroundCheckpointer::load(BackgroundSnapshot& out) {
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = loadBackgroundCheckpoint(opts_.path, out);
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.load_ms = ms;
+    stats_.loaded_models = ok ? out.models.size() : 0;
+    return ok;
+}
+
+void BackgroundCheckpointer::checkpoint(const MotionDetector& detector, uint64_t frame_id,
+                                        bool force, const MotionDetector::Config* as) {
+    const auto now = std::chrono::steady_clock::now();
+    if (!force && now < next_due_) return;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_) return;
+        if (force) {
+            cv_.wait(lock, [this] { return !busy_ || !running_; });
+            if (!running_) return;
+        } else if (busy_) {
+            ++stats_.skipped;
+            next_due_ = now + std::chrono::milliseconds(opts_.interval_ms);
+            return;
+        }
+    }
+
+    // The writer is idle, so snapshot_ is ours until busy_ is set
+    detector.snapshotBackground(snapshot_, as);
+    snapshot_.frame_id = frame_id;
+    snapshot_.saved_unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - now).count();
+    next_due_ = now + std::chrono::milliseconds(opts_.interval_ms);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.snapshot_ms += ms;
+    busy_ = !snapshot_.models.empty();  // nothing learned yet: nothing to save
+    cv_.notify_all();
+}
+
+void BackgroundCheckpointer::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return busy_ || !running_; });
+        if (!busy_) break;  // stopped with nothing pending
+
+        lock.unlock();
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = saveBackgroundCheckpoint(opts_.path, snapshot_);
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+        if (!ok) {
+            std::cerr << "BackgroundCheckpointer: failed to write " << opts_.path << std::endl;
+        }
+        lock.lock();
+
+        if (ok) {
+            ++stats_.written;
+            stats_.bytes = snapshot_.bytes();
+        } else {
+            ++stats_.failed;
+        }
+        stats_.write_ms += ms;
+        busy_ = false;
+        cv_.notify_all();
+    }
+}
+
+BackgroundCheckpointer::Stats BackgroundCheckpointer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
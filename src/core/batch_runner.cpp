@@ -0,0 +1,134 @@
+#include "core/batch_runner.hpp"
+#include "core/motion_consumer.hpp"
+#include "core/worker_pool.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+
+BatchRunner::BatchRunner(const Options& opts) : opts_(opts) {}
+
+bool BatchRunner::run(EventLog& log, Report& report) {
+    cv::VideoCapture probe(opts_.path);
+    if (!probe.isOpened()) {
+        std::cerr << "Failed to open: " << opts_.path << std::endl;
+        return false;
+    }
+    double fps = probe.get(cv::CAP_PROP_FPS);
+    if (fps <= 0) fps = 30.0;
+    auto total = static_cast<uint64_t>(std::max(0.0, probe.get(cv::CAP_PROP_FRAME_COUNT)));
+    probe.release();
+
+    WorkerPool pool(opts_.workers);
+    size_t count = opts_.segments ? opts_.segments : pool.size();
+    // Containers without a frame count, or short files: one sequential pass
+    if (total == 0 || total < count * std::max<size_t>(opts_.warmup_frames, 1) * 2) {
+        count = 1;
+    }
+
+    std::vector<Segment> segments(count);
+    uint64_t per_segment = count > 1 ? total / count : 0;
+    for (size_t i = 0; i < count; ++i) {
+        segments[i].begin = i * per_segment;
+        // The frame count is only an estimate, so the last segment reads to EOF
+        segments[i].end = (i + 1 == count)
+            ? std::numeric_limits<uint64_t>::max()
+            : (i + 1) * per_segment;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    size_t remaining = count;
+    size_t head = 0;  // earliest segment not yet done
+    segments[0].live = true;
+    std::function<void(Segment&)> run_segment = [&, fps](Segment& segment) {
+        if (!processSegment(segment, fps, log)) return;  // paused
+        std::lock_guard<std::mutex> lock(done_mutex);
+        segment.done = true;
+        if (head < count && &segment == &segments[head]) {
+            while (head < count && segments[head].done) goLive(segments[head++], log);
+            if (head < count && goLive(segments[head], log)) {
+                Segment& next = segments[head];
+                pool.submit([&run_segment, &next] { run_segment(next); });
+            }
+        }
+        if (--remaining == 0) done_cv.notify_one();
+    };
+    for (auto& segment : segments) {
+        pool.submit([&run_segment, &segment] { run_segment(segment); });
+    }
+    {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cv.wait(lock, [&] { return remaining == 0; });
+    }
+    report.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    report.segments = count;
+    bool ok = true;
+    for (auto& segment : segments) {
+        ok = ok && segment.ok;
+        report.frames += segment.frames;
+        report.decoded += segment.decoded;
+    }
+    return ok;
+}
+
+bool BatchRunner::goLive(Segment& segment, EventLog& log) {
+    std::lock_guard<std::mutex> lock(segment.mutex);
+    for (const auto& event : segment.events) log.appendBlocking(event);
+    segment.events = {};
+    segment.live = true;
+    bool resume = segment.paused;
+    segment.paused = false;
+    return resume;
+}
+
+bool BatchRunner::processSegment(Segment& segment, double fps, EventLog& log) const {
+    if (!segment.detector) {
+        segment.cap.open(opts_.path);
+        if (!segment.cap.isOpened()) return true;
+
+        uint64_t first = segment.begin > opts_.warmup_frames
+            ? segment.begin - opts_.warmup_frames : 0;
+        if (first > 0) segment.cap.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(first));
+        segment.next = first;
+
+        MotionDetectorConfig batch_config = opts_.config;
+        batch_config.visualize = false;
+        segment.detector.reset(new MotionDetector(MotionConsumer::toDetectorConfig(batch_config)));
+    }
+
+    cv::Mat frame;
+    for (; segment.next < segment.end; ++segment.next) {
+        const uint64_t index = segment.next;
+        if (!segment.cap.read(frame) || frame.empty()) break;
+        ++segment.decoded;
+
+        auto ts = static_cast<int64_t>(index * 1000.0 / fps);
+        segment.detector->process(frame, index, ts);
+        if (index >= segment.begin) {
+            const std::vector<MotionEvent>& events = segment.detector->events();
+            std::lock_guard<std::mutex> lock(segment.mutex);
+            ++segment.frames;
+            if (segment.live) {
+                for (const auto& event : events) log.appendBlocking(event);
+            } else {
+                segment.events.insert(segment.events.end(), events.begin(), events.end());
+                if (segment.events.size() >= opts_.max_buffered_events) {
+                    // Resumed by goLive() once every earlier segment is done
+                    ++segment.next;
+                    segment.paused = true;
+                    return false;
+                }
+            }
+        }
+    }
+    segment.cap.release();
+    segment.detector.reset();
+    segment.ok = true;
+    return true;
+}
@@ -0,0 +1,217 @@
+#include "core/clip_recorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+ClipRecorder::ClipRecorder(const Options& opts, WorkerPool& pool)
+    : opts_(opts), pool_(pool) {}
+
+ClipRecorder::~ClipRecorder() {
+    stop();
+}
+
+bool ClipRecorder::start() {
+    std::error_code ec;
+    std::filesystem::create_directories(opts_.directory, ec);
+    if (ec) {
+        std::cerr << "ClipRecorder: cannot create " << opts_.directory << ": "
+                  << ec.message() << std::endl;
+        return false;
+    }
+    running_ = true;
+    writer_ = std::thread(&ClipRecorder::writerLoop, this);
+    return true;
+}
+
+void ClipRecorder::stop() {
+    if (!running_) return;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return inflight_.empty(); });
+        if (recording_ && !clips_.empty()) {
+            clips_.back().end_frame = pushed_upto_;
+            recording_ = false;
+        }
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+    running_ = false;
+}
+
+void ClipRecorder::push(const TimestampedFrame& tf, bool motion) {
+    const int64_t ts = tf.timestamp_ms;
+    if (motion) last_motion_ms_ = ts;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (motion && !recording_) {
+            recording_ = true;
+            Clip clip;
+            clip.start_ms = ts - static_cast<int64_t>(opts_.pre_seconds * 1000.0);
+            clip.path = opts_.directory + "/" + opts_.prefix + "_" +
+                        std::to_string(tf.frame_id) + ".mjpeg";
+            clips_.push_back(clip);
+        } else if (recording_ && !motion &&
+                   ts - last_motion_ms_ >= static_cast<int64_t>(opts_.post_seconds * 1000.0)) {
+            recording_ = false;
+            // The writer drops a clip whose file failed, so it may be gone
+            if (!clips_.empty()) clips_.back().end_frame = tf.frame_id;
+        }
+        pushed_upto_ = any_pushed_ ? std::max(pushed_upto_, tf.frame_id) : tf.frame_id;
+        any_pushed_ = true;
+
+        if (inflight_count_.load(std::memory_order_relaxed) >= opts_.max_inflight) {
+            ++stats_.encode_dropped;
+            cv_.notify_all();
+            return;
+        }
+        inflight_.insert(tf.frame_id);
+        inflight_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // The task holds a reference to the pooled buffer until it is encoded
+    pool_.submit([this, frame = tf.frame, id = tf.frame_id, ts]() mutable {
+        encode(std::move(frame), id, ts);
+    });
+}
+
+void ClipRecorder::encode(cv::Mat frame, uint64_t frame_id, int64_t timestamp_ms) {
+    auto t0 = std::chrono::steady_clock::now();
+    auto encoded = std::make_shared<Encoded>();
+    encoded->frame_id = frame_id;
+    encoded->timestamp_ms = timestamp_ms;
+    cv::imencode(".jpg", frame, encoded->jpeg, {cv::IMWRITE_JPEG_QUALITY, opts_.jpeg_quality});
+    frame.release();
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inflight_.erase(inflight_.find(frame_id));
+        inflight_count_.fetch_sub(1, std::memory_order_relaxed);
+        ++stats_.frames_encoded;
+        stats_.bytes_encoded += encoded->jpeg.size();
+        stats_.encode_ms += ms;
+        if (!encoded->jpeg.empty()) insert(std::move(encoded));
+        evict();
+        // Under the lock: once inflight_ is empty stop() may destroy us
+        cv_.notify_all();
+    }
+}
+
+/** Keeps ring_ ordered by frame id; encodes finish slightly out of order */
+void ClipRecorder::insert(EncodedPtr frame) {
+    auto pos = ring_.end();
+    while (pos != ring_.begin() && (*(pos - 1))->frame_id > frame->frame_id) --pos;
+    ring_bytes_ += frame->jpeg.size();
+    ring_.insert(pos, std::move(frame));
+}
+
+/**
+ * Drops frames older than the pre-roll unless the pending clip still needs
+ * them; over max_bytes, drops the oldest regardless.
+ */
+void ClipRecorder::evict() {
+    if (ring_.empty()) return;
+    const int64_t horizon = ring_.back()->timestamp_ms -
+                            static_cast<int64_t>(opts_.pre_seconds * 1000.0);
+    while (!ring_.empty()) {
+        const Encoded& f = *ring_.front();
+        bool needed = !clips_.empty() && f.timestamp_ms >= clips_.front().start_ms &&
+                      (!any_written_ || f.frame_id > written_upto_);
+        if (ring_bytes_ > opts_.max_bytes) {
+            if (needed) ++stats_.evicted_unwritten;
+        } else if (needed || f.timestamp_ms >= horizon) {
+            break;
+        }
+        ring_bytes_ -= f.jpeg.size();
+        ring_.pop_front();
+    }
+}
+
+// Every frame id below this is final: encoded into the ring or dropped
+uint64_t ClipRecorder::settledBefore() const {
+    if (!inflight_.empty()) return *inflight_.begin();
+    return any_pushed_ ? pushed_upto_ + 1 : 0;
+}
+
+void ClipRecorder::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<EncodedPtr> batch;
+    while (true) {
+        if (clips_.empty()) {
+            if (stopping_) break;
+            cv_.wait(lock);
+            continue;
+        }
+        // References into a deque survive push_back from push()
+        Clip& clip = clips_.front();
+        const uint64_t settled = settledBefore();
+        batch.clear();
+        for (const EncodedPtr& f : ring_) {
+            if (f->frame_id >= settled || f->frame_id > clip.end_frame) break;
+            if (any_written_ && f->frame_id <= written_upto_) continue;
+            if (f->timestamp_ms >= clip.start_ms) batch.push_back(f);
+        }
+        if (!batch.empty()) {
+            written_upto_ = batch.back()->frame_id;
+            any_written_ = true;
+            if (!writeFrames(clip, batch, lock)) {
+                clips_.pop_front();
+            }
+            continue;
+        }
+
+        bool complete = clip.end_frame != UINT64_MAX && settled > clip.end_frame;
+        if (complete || stopping_) {
+            if (file_) {
+                std::fclose(file_);
+                file_ = nullptr;
+                ++stats_.clips;
+            }
+            clips_.pop_front();
+            evict();
+            continue;
+        }
+        cv_.wait(lock);
+    }
+}
+
+/** Appends batch to the clip's file with the lock released */
+bool ClipRecorder::writeFrames(Clip& clip, std::vector<EncodedPtr>& batch,
+                               std::unique_lock<std::mutex>& lock) {
+    const std::string path = clip.path;
+    lock.unlock();
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = true;
+    if (!file_) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            std::cerr << "ClipRecorder: failed to open " << path << std::endl;
+            ok = false;
+        }
+    }
+    uint64_t bytes = 0;
+    for (size_t i = 0; ok && i < batch.size(); ++i) {
+        const std::vector<uchar>& jpeg = batch[i]->jpeg;
+        ok = std::fwrite(jpeg.data(), 1, jpeg.size(), file_) == jpeg.size();
+        bytes += jpeg.size();
+    }
+    if (!ok && file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    lock.lock();
+
+    if (ok) stats_.frames_written += batch.size();
+    stats_.bytes_written += bytes;
+    stats_.write_seconds += seconds;
+    batch.clear();  // drop references before eviction
+    evict();
+    return ok;
+}
+
+ClipRecorder::Stats ClipRecorder::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
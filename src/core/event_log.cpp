@@ -0,0 +1,142 @@
+#include "core/event_log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+EventLog::EventLog(const Options& opts)
+    : opts_(opts), ring_(opts.buffer_capacity) {}
+
+EventLog::~EventLog() {
+    stop();
+}
+
+bool EventLog::start() {
+    if (!openSegment(0)) return false;
+    running_ = true;
+    writer_ = std::thread(&EventLog::writerLoop, this);
+    return true;
+}
+
+void EventLog::stop() {
+    running_ = false;
+    if (writer_.joinable()) writer_.join();
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    binary_.close();
+}
+
+bool EventLog::append(const MotionEvent& event) {
+    MotionEvent copy = event;
+    if (ring_.tryPush(std::move(copy))) return true;
+    ++dropped_;
+    return false;
+}
+
+void EventLog::appendBlocking(const MotionEvent& event) {
+    MotionEvent copy = event;
+    while (!ring_.tryPush(std::move(copy))) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+std::string EventLog::segmentPath(size_t index) const {
+    if (index == 0) return opts_.path;
+    size_t dot = opts_.path.find_last_of('.');
+    size_t slash = opts_.path.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return opts_.path + "." + std::to_string(index);
+    }
+    return opts_.path.substr(0, dot) + "." + std::to_string(index) + opts_.path.substr(dot);
+}
+
+std::string EventLog::currentPath() const {
+    return segmentPath(segment_);
+}
+
+bool EventLog::openSegment(size_t index) {
+    std::string path = segmentPath(index);
+    bool ok;
+    if (opts_.format == Format::BINARY) {
+        // Rows per segment so the reserved file size matches max_file_bytes
+        ok = binary_.open(path, std::max<size_t>(1, opts_.max_file_bytes / MotionLogWriter::rowBytes()));
+    } else {
+        if (file_) std::fclose(file_);
+        file_ = std::fopen(path.c_str(), "w");
+        ok = file_ != nullptr;
+        if (ok) segment_bytes_ = std::fwrite(kMotionCsvHeader, 1, std::strlen(kMotionCsvHeader), file_);
+    }
+    if (!ok) {
+        std::cerr << "EventLog: failed to open " << path << std::endl;
+        return false;
+    }
+    segment_ = index;
+
+    if (opts_.max_files > 0 && index >= opts_.max_files) {
+        std::remove(segmentPath(index - opts_.max_files).c_str());
+    }
+    return true;
+}
+
+size_t EventLog::drainBatch(std::vector<MotionEvent>& batch) {
+    batch.clear();
+    MotionEvent event;
+    while (batch.size() < opts_.batch_size && ring_.tryPop(event)) {
+        batch.push_back(event);
+    }
+    return batch.size();
+}
+
+void EventLog::writeBatch(const std::vector<MotionEvent>& batch) {
+    char line[256];
+    for (const auto& e : batch) {
+        if (opts_.format == Format::BINARY) {
+            if (binary_.full() && !openSegment(segment_ + 1)) return;
+            binary_.append(e);
+        } else {
+            if (segment_bytes_ >= opts_.max_file_bytes && !openSegment(segment_ + 1)) return;
+            int n = formatMotionCsvRow(e, line, sizeof(line));
+            segment_bytes_ += std::fwrite(line, 1, static_cast<size_t>(n), file_);
+        }
+        ++written_;
+    }
+}
+
+void EventLog::flushSegment() {
+    if (file_) std::fflush(file_);
+    binary_.flush();
+}
+
+bool EventLog::isOpen() const {
+    return file_ || binary_.isOpen();
+}
+
+void EventLog::writerLoop() {
+    using clock = std::chrono::steady_clock;
+    std::vector<MotionEvent> batch;
+    batch.reserve(opts_.batch_size);
+    auto flush_interval = std::chrono::milliseconds(opts_.flush_interval_ms);
+    auto last_flush = clock::now();
+    bool dirty = false;
+
+    while (running_) {
+        if (drainBatch(batch) > 0) {
+            if (isOpen()) writeBatch(batch);
+            dirty = true;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        if (dirty && clock::now() - last_flush >= flush_interval) {
+            flushSegment();
+            last_flush = clock::now();
+            dirty = false;
+        }
+    }
+
+    while (drainBatch(batch) > 0) {
+        if (isOpen()) writeBatch(batch);
+    }
+    flushSegment();
+}
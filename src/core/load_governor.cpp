@@ -0,0 +1,115 @@
+#include "core/load_governor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// Assumed cost of a rung until it has been measured
+constexpr double kDefaultStepCost = 2.0;
+
+}  // namespace
+
+const std::vector<LoadGovernor::Rung>& LoadGovernor::ladder() {
+    static const std::vector<Rung> rungs = {
+        {"configured quality", 1.0, 1, 1.0, true},
+        {"processing scale x0.5", 0.5, 1, 1.0, true},
+        {"analysis rate /2", 0.5, 2, 1.0, true},
+        {"blur kernel x0.5", 0.5, 2, 0.5, true},
+        {"visualization off", 0.5, 2, 0.5, false},
+        {"processing scale x0.25, analysis rate /4", 0.25, 4, 0.5, false},
+    };
+    return rungs;
+}
+
+void LoadGovernor::applyRung(const Rung& rung, MotionDetector::Config& cfg) {
+    if (rung.scale < 1.0) {
+        if (cfg.pyramid_levels > 0) {
+            cfg.pyramid_levels += static_cast<int>(std::lround(-std::log2(rung.scale)));
+        } else {
+            cfg.process_scale *= rung.scale;
+        }
+    }
+    if (rung.blur < 1.0) {
+        cfg.blur_kernel = std::max(3, static_cast<int>(cfg.blur_kernel * rung.blur) | 1);
+    }
+    cfg.visualize = cfg.visualize && rung.visualize;
+}
+
+LoadGovernor::LoadGovernor(const Options& opts)
+    : opts_(opts)
+    , max_level_(static_cast<int>(ladder().size()) - 1)
+    , cost_(ladder().size(), kDefaultStepCost) {
+    if (opts_.max_level >= 0) max_level_ = std::min(max_level_, opts_.max_level);
+}
+
+bool LoadGovernor::observe(int64_t now_ns, int64_t process_ns, size_t queue_depth,
+                           size_t queue_capacity, uint64_t frame_id, int64_t timestamp_ms,
+                           Transition& out) {
+    if (samples_ == 0) window_start_ns_ = now_ns - process_ns;
+    busy_ns_ += process_ns;
+    depth_sum_ += static_cast<double>(queue_depth);
+    ++samples_;
+    const int64_t elapsed = now_ns - window_start_ns_;
+    if (elapsed < static_cast<int64_t>(opts_.window_ms) * 1000000) return false;
+
+    const double load = static_cast<double>(busy_ns_) / elapsed;
+    const double fill = queue_capacity > 0 ? depth_sum_ / samples_ / queue_capacity : 0.0;
+    busy_ns_ = 0;
+    depth_sum_ = 0.0;
+    samples_ = 0;
+    last_load_milli_.store(static_cast<int>(load * 1000), std::memory_order_relaxed);
+
+    const int level = level_.load(std::memory_order_relaxed);
+    const bool settled = now_ns - last_change_ns_ >= static_cast<int64_t>(opts_.settle_ms) * 1000000;
+    if (measure_step_ && settled) {
+        // What the last step down saved, for judging the way back up
+        cost_[level - 1] = std::clamp(load_before_step_ / std::max(load, 0.01), 1.0, 16.0);
+        measure_step_ = false;
+    }
+
+    char reason[160];
+    if (load > opts_.high_load || fill > opts_.high_fill) {
+        calm_since_ns_ = 0;
+        if (level >= max_level_ || !settled) return false;
+        if (load > opts_.high_load) {
+            std::snprintf(reason, sizeof(reason), "load %.2f > %.2f", load, opts_.high_load);
+        } else {
+            std::snprintf(reason, sizeof(reason), "queue %.0f%% full > %.0f%%",
+                          fill * 100, opts_.high_fill * 100);
+        }
+        load_before_step_ = load;
+        measure_step_ = true;
+        change(level + 1, now_ns, load, fill, frame_id, timestamp_ms, reason, out);
+        out.from = level;
+        return true;
+    }
+
+    const double projected = level > 0 ? load * cost_[level - 1] : 0.0;
+    if (level == 0 || fill > opts_.low_fill || projected >= opts_.high_load) {
+        calm_since_ns_ = 0;
+        return false;
+    }
+    if (calm_since_ns_ == 0) calm_since_ns_ = now_ns;
+    if (now_ns - calm_since_ns_ < static_cast<int64_t>(opts_.recover_ms) * 1000000) return false;
+
+    std::snprintf(reason, sizeof(reason), "load %.2f (%.2f projected one rung up) for %.0f s",
+                  load, projected, opts_.recover_ms / 1000.0);
+    calm_since_ns_ = 0;
+    change(level - 1, now_ns, load, fill, frame_id, timestamp_ms, reason, out);
+    out.from = level;
+    return true;
+}
+
+void LoadGovernor::change(int to, int64_t now_ns, double load, double fill, uint64_t frame_id,
+                          int64_t timestamp_ms, std::string reason, Transition& out) {
+    level_.store(to, std::memory_order_relaxed);
+    transitions_.fetch_add(1, std::memory_order_relaxed);
+    last_change_ns_ = now_ns;
+    out.to = to;
+    out.frame_id = frame_id;
+    out.timestamp_ms = timestamp_ms;
+    out.load = load;
+    out.fill = fill;
+    out.reason = std::move(reason);
+}
@@ -0,0 +1,236 @@
+#include "core/metrics.hpp"
+
+#if MOTION_METRICS
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+void LatencyHistogram::record(int64_t ns) {
+    uint64_t v = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    buckets_[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(v, std::memory_order_relaxed);
+    uint64_t prev = max_.load(std::memory_order_relaxed);
+    while (v > prev && !max_.compare_exchange_weak(prev, v, std::memory_order_relaxed)) {}
+}
+
+int LatencyHistogram::bucketOf(uint64_t ns) {
+    if (ns < static_cast<uint64_t>(kSubBuckets)) return static_cast<int>(ns);
+    int exponent = 63 - __builtin_clzll(ns);
+    if (exponent > kMaxExponent) return kBuckets - 1;
+    int sub = static_cast<int>(ns >> (exponent - kSubBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucketMid(int bucket) {
+    if (bucket < kSubBuckets) return static_cast<uint64_t>(bucket);
+    int exponent = bucket / kSubBuckets + kSubBits - 1;
+    int sub = bucket % kSubBuckets;
+    int shift = exponent - kSubBits;
+    uint64_t low = static_cast<uint64_t>(kSubBuckets + sub) << shift;
+    return low + ((1ull << shift) >> 1);
+}
+
+uint64_t LatencyHistogram::quantileNs(double q) const {
+    uint64_t counts[kBuckets];
+    uint64_t total = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(q * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(bucketMid(i), maxNs());
+    }
+    return maxNs();
+}
+
+// ---------------------------------------------------------------------------
+
+MetricsRegistry& MetricsRegistry::global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Series& MetricsRegistry::find(const std::string& name, const std::string& help,
+                                               const std::string& labels, bool is_histogram) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family* family = nullptr;
+    for (auto& f : families_) {
+        if (f.name == name) family = &f;
+    }
+    if (!family) {
+        families_.push_back(Family{name, help, is_histogram, {}});
+        family = &families_.back();
+    }
+    for (auto& series : family->series) {
+        if (series.labels == labels) return series;
+    }
+    family->series.push_back(Series{labels, nullptr, nullptr});
+    Series& series = family->series.back();
+    if (family->is_histogram) {
+        series.histogram = std::make_unique<LatencyHistogram>();
+    } else {
+        series.gauge = std::make_unique<Gauge>();
+    }
+    return series;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                             const std::string& labels) {
+    return *find(name, help, labels, true).histogram;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                              const std::string& labels) {
+    return *find(name, help, labels, false).gauge;
+}
+
+std::string MetricsRegistry::render() const {
+    static const double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+    std::string out;
+    char line[512];
+    auto braces = [](const std::string& labels, const std::string& extra) {
+        std::string all = labels;
+        if (!extra.empty()) all += (all.empty() ? "" : ",") + extra;
+        return all.empty() ? all : "{" + all + "}";
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& family : families_) {
+        out += "# HELP " + family.name + " " + family.help + "\n";
+        out += "# TYPE " + family.name + (family.is_histogram ? " summary\n" : " gauge\n");
+        for (const auto& series : family.series) {
+            if (!family.is_histogram) {
+                std::snprintf(line, sizeof(line), "%s%s %lld\n", family.name.c_str(),
+                              braces(series.labels, "").c_str(),
+                              static_cast<long long>(series.gauge->value()));
+                out += line;
+                continue;
+            }
+            const LatencyHistogram& h = *series.histogram;
+            for (double q : kQuantiles) {
+                char quantile[32];
+                std::snprintf(quantile, sizeof(quantile), "quantile=\"%g\"", q);
+                std::snprintf(line, sizeof(line), "%s%s %.9f\n", family.name.c_str(),
+                              braces(series.labels, quantile).c_str(), h.quantileNs(q) / 1e9);
+                out += line;
+            }
+            std::snprintf(line, sizeof(line), "%s_sum%s %.9f\n%s_count%s %llu\n",
+                          family.name.c_str(), braces(series.labels, "").c_str(), h.sumNs() / 1e9,
+                          family.name.c_str(), braces(series.labels, "").c_str(),
+                          static_cast<unsigned long long>(h.count()));
+            out += line;
+        }
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+
+MetricsExporter::MetricsExporter(const Options& opts) : opts_(opts) {}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start() {
+    if (!opts_.socket_path.empty()) {
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (listen_fd_ < 0 || opts_.socket_path.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Bad metrics socket: " << opts_.socket_path << std::endl;
+            stop();
+            return false;
+        }
+        std::strncpy(addr.sun_path, opts_.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(opts_.socket_path.c_str());
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listen_fd_, 4) != 0) {
+            std::cerr << "Failed to listen on " << opts_.socket_path << ": "
+                      << std::strerror(errno) << std::endl;
+            stop();
+            return false;
+        }
+    }
+    running_ = true;
+    thread_ = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        ::unlink(opts_.socket_path.c_str());
+        listen_fd_ = -1;
+    }
+}
+
+void MetricsExporter::run() {
+    auto next_write = std::chrono::steady_clock::now();
+    while (running_) {
+        auto now = std::chrono::steady_clock::now();
+        if (!opts_.path.empty() && now >= next_write) {
+            writeFile(MetricsRegistry::global().render());
+            next_write = now + std::chrono::milliseconds(opts_.interval_ms);
+        }
+        if (listen_fd_ >= 0) {
+            serveClients();  // waits up to 100 ms for a connection
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    // Final snapshot so the file reflects the whole run
+    if (!opts_.path.empty()) writeFile(MetricsRegistry::global().render());
+}
+
+bool MetricsExporter::writeFile(const std::string& text) const {
+    std::string tmp = opts_.path + ".tmp";
+    FILE* file = std::fopen(tmp.c_str(), "w");
+    if (!file) return false;
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok && std::rename(tmp.c_str(), opts_.path.c_str()) == 0;
+}
+
+void MetricsExporter::serveClients() {
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    if (::poll(&pfd, 1, 100) <= 0) return;
+    int client = ::accept(listen_fd_, nullptr, nullptr);
+    if (client < 0) return;
+
+    // The request itself is ignored; every path returns the metrics
+    char request[1024];
+    pollfd cfd{client, POLLIN, 0};
+    if (::poll(&cfd, 1, 100) > 0) {
+        ssize_t ignored = ::recv(client, request, sizeof(request), 0);
+        (void)ignored;
+    }
+    std::string body = MetricsRegistry::global().render();
+    std::string response =
+        "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+        std::to_string(body.size()) + "\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += static_cast<size_t>(n);
+    }
+    ::close(client);
+}
+
+#endif  // MOTION_METRICS
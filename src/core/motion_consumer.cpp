@@ -1,12 +1,24 @@
 #include "core/motion_consumer.hpp"
+#include <chrono>
+#include "core/video_capture.hpp"
+
+namespace {
+
+constexpr size_t kResultReaderFrames = 2;
+
+}  // namespace
 
 MotionConsumer::MotionConsumer(FrameQueue& buffer,
                                ThreadQueue<MotionDetectorConfig>& config_queue,
-                               ThreadQueue<DetectionResult>& result_queue)
+                               BroadcastChannel<DetectionResult>& results)
     : buffer_(buffer)
     , config_queue_(config_queue)
-    , result_queue_(result_queue)
-    , detector_() {}
+    , results_(results)
+    , detector_() {
+    // Frames attached to results stay pinned by the result ring, and readers
+    // hold one more each (display, preview) while drawing
+    buffer_.pool().addCapacity(results_.capacity() + kResultReaderFrames);
+}
 
 MotionConsumer::~MotionConsumer() { 
     stop(); 
@@ -22,49 +34,210 @@ void MotionConsumer::stop() {
     if (processing_thread_.joinable()) {
         processing_thread_.join();
     }
+    finishEpisodes();
+    saveCheckpoint();
 }
 
-void MotionConsumer::applyConfig(const MotionDetectorConfig& config) {
+MotionDetector::Config MotionConsumer::toDetectorConfig(const MotionDetectorConfig& config) {
     MotionDetector::Config motion_detector_cfg;
     motion_detector_cfg.roi = config.roi;
+    motion_detector_cfg.rois = config.rois;
     motion_detector_cfg.threshold = config.threshold;
     motion_detector_cfg.blur_kernel = config.blur_kernel;
     motion_detector_cfg.min_contour_area = config.min_contour_area;
     motion_detector_cfg.learning_rate = config.learning_rate;
-    
-    detector_.setConfig(motion_detector_cfg);
+    motion_detector_cfg.process_scale = config.process_scale;
+    motion_detector_cfg.pyramid_levels = config.pyramid_levels;
+    motion_detector_cfg.refine = config.refine;
+    motion_detector_cfg.tile_size = config.tile_size;
+    motion_detector_cfg.fixed_point = config.fixed_point;
+    motion_detector_cfg.full_frame_background = config.full_frame_background;
+    motion_detector_cfg.strips = config.strips;
+    motion_detector_cfg.visualize = config.visualize;
+    return motion_detector_cfg;
+}
+
+void MotionConsumer::applyConfig(const MotionDetectorConfig& config) {
+    base_config_ = toDetectorConfig(config);
+    if (governor_) {
+        applyGovernedConfig();
+    } else {
+        detector_.setConfig(base_config_);
+    }
+}
+
+void MotionConsumer::applyGovernedConfig() {
+    const LoadGovernor::Rung& rung = governor_->rung();
+    MotionDetector::Config cfg = base_config_;
+    LoadGovernor::applyRung(rung, cfg);
+    detector_.setConfig(cfg);
+    if (governed_capture_) governed_capture_->setAnalysisDivisor(rung.rate_divisor);
+    if (metrics_.governor_level) metrics_.governor_level->set(governor_->level());
+}
+
+void MotionConsumer::setLoadGovernor(LoadGovernor* governor, VideoCapture* capture,
+                                     GovernorCallback callback) {
+    governor_ = governor;
+    governed_capture_ = capture;
+    governor_callback_ = std::move(callback);
+    if (governor_) applyGovernedConfig();
 }
 
 void MotionConsumer::processLoop() {
     while (running_) {
-        // Check for config updates
-        if (auto config = config_queue_.tryPopLatest()) {
-            applyConfig(*config);
-        }
-        
         // Get frame
         TimestampedFrame tf;
-        if (!buffer_.pop(tf, 100)) continue;
-        
-        // Process
-        auto event = detector_.process(tf.frame, tf.frame_id, tf.timestamp_ms);
-        cv::Mat viz = detector_.getVisualization();
-        
-        // Add overlay
-        char stats[128];
-        snprintf(stats, sizeof(stats),
-            "Motion: %.2f%% | Objects: %d | Frame: %lu",
-            event.motion_score, event.contour_count, tf.frame_id);
-        cv::putText(viz, stats, cv::Point(10, 30),
-            cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
-        
-        /**
-         * 
-         */
-        result_queue_.push(DetectionResult{std::move(viz), event});
-    }
-}
-
-void MotionConsumer::exportCSV(const std::string& path) const {
-    detector_.exportCSV(path);
-}
\ No newline at end of file
+        if (!buffer_.pop(tf, 100)) {
+            // Still pick up config changes while the source is idle
+            if (auto config = config_queue_.tryPopLatest()) {
+                applyConfig(*config);
+            }
+            continue;
+        }
+        processFrame(tf);
+    }
+}
+
+size_t MotionConsumer::drain(size_t max_frames) {
+    size_t processed = 0;
+    TimestampedFrame tf;
+    while (processed < max_frames && buffer_.pop(tf, 0)) {
+        processFrame(tf);
+        ++processed;
+    }
+    return processed;
+}
+
+void MotionConsumer::processFrame(TimestampedFrame& tf) {
+    const auto started = std::chrono::steady_clock::now();
+    const size_t queue_depth = governor_ ? buffer_.size() : 0;
+    if (metrics_.queue_wait && tf.capture_ns) {
+        metrics_.queue_wait->record(metricsNow() - tf.capture_ns);
+        metrics_.queue_depth->set(static_cast<int64_t>(buffer_.size()));
+    }
+
+    // Check for config updates
+    if (auto config = config_queue_.tryPopLatest()) {
+        applyConfig(*config);
+    }
+
+    // Process
+    detector_.process(tf.frame, tf.frame_id, tf.timestamp_ms);
+    const std::vector<MotionEvent>& events = detector_.events();
+    if (shm_publisher_) shm_publisher_->publish(tf, detector_);
+    if (checkpointer_) checkpointer_->checkpoint(detector_, tf.frame_id, false, checkpointConfig());
+    last_frame_id_ = tf.frame_id;
+    if (event_log_) {
+        for (const auto& event : events) event_log_->append(event);
+    }
+    bool in_episode;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        for (const auto& event : events) stats_.add(event, finished_);
+        in_episode = stats_.inEpisode();
+    }
+    if (clip_recorder_) clip_recorder_->push(tf, in_episode);
+    for (const auto& episode : finished_) {
+        if (episode_callback_) episode_callback_(episode);
+    }
+    finished_.clear();
+    const MotionDetector::FrameStats& stats = detector_.frameStats();
+    tiles_processed_.fetch_add(stats.tiles_dirty, std::memory_order_relaxed);
+    tiles_skipped_.fetch_add(stats.tilesSkipped(), std::memory_order_relaxed);
+
+    // Filled in place: assigning reuses a recycled result's vectors
+    DetectionResult& result = results_.claim();
+    result.frame = cv::Mat();
+    result.events = events;
+    result.boxes = detector_.boxes();
+    int64_t interval = display_interval_ms_.load(std::memory_order_relaxed);
+    const int64_t preview = preview_interval_ms_.load(std::memory_order_relaxed);
+    if (preview >= 0 && (interval < 0 || preview < interval)) interval = preview;
+    if (!detector_.config().visualize) interval = -1;
+    if (interval >= 0 && (interval == 0 || last_display_ms_ == INT64_MIN ||
+                          tf.timestamp_ms - last_display_ms_ >= interval)) {
+        result.frame = tf.frame;  // Shared reference, drawn only when shown
+        last_display_ms_ = tf.timestamp_ms;
+    }
+    results_.publish();
+
+    if (metrics_.end_to_end && tf.capture_ns) {
+        metrics_.end_to_end->record(metricsNow() - tf.capture_ns);
+        metrics_.result_lag->set(static_cast<int64_t>(results_.maxLag()));
+    }
+
+    if (governor_) {
+        LoadGovernor::Transition transition;
+        const auto now = std::chrono::steady_clock::now();
+        const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now.time_since_epoch()).count();
+        const int64_t process_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - started).count();
+        if (governor_->observe(now_ns, process_ns, queue_depth, buffer_.capacity(),
+                               tf.frame_id, tf.timestamp_ms, transition)) {
+            applyGovernedConfig();
+            if (governor_callback_) governor_callback_(transition);
+        }
+    }
+}
+
+void MotionConsumer::enableMetrics(const std::string& labels) {
+    MetricsRegistry& registry = MetricsRegistry::global();
+    metrics_.queue_wait = &registry.histogram("motion_queue_wait_seconds",
+        "Time from capture to dequeue by the detector", labels);
+    metrics_.end_to_end = &registry.histogram("motion_end_to_end_seconds",
+        "Time from capture to result published", labels);
+    metrics_.queue_depth = &registry.gauge("motion_frame_queue_depth",
+        "Frames waiting in the capture queue", labels);
+    metrics_.result_lag = &registry.gauge("motion_result_subscriber_lag",
+        "Results the slowest result subscriber has yet to read", labels);
+    metrics_.governor_level = &registry.gauge("motion_governor_level",
+        "Load governor ladder rung, 0 = configured quality", labels);
+    detector_.enableMetrics(labels);
+}
+
+void MotionConsumer::setCheckpointer(BackgroundCheckpointer* checkpointer) {
+    checkpointer_ = checkpointer;
+    BackgroundSnapshot snapshot;
+    if (checkpointer_ && checkpointer_->load(snapshot)) {
+        detector_.restoreBackground(std::move(snapshot));
+    }
+}
+
+void MotionConsumer::saveCheckpoint() {
+    if (checkpointer_) {
+        checkpointer_->checkpoint(detector_, last_frame_id_, true, checkpointConfig());
+    }
+    checkpointer_ = nullptr;
+}
+
+void MotionConsumer::setEpisodeOptions(const EpisodeDetector::Options& opts) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_ = MotionStats(opts);
+}
+
+void MotionConsumer::finishEpisodes() {
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.finish(finished_);
+    }
+    for (const auto& episode : finished_) {
+        if (episode_callback_) episode_callback_(episode);
+    }
+    finished_.clear();
+}
+
+std::vector<MotionStats::RoiSummary> MotionConsumer::statsSummary() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_.summary();
+}
+
+void MotionConsumer::setDisplayRate(double fps) {
+    display_interval_ms_.store(fps > 0 ? static_cast<int64_t>(1000.0 / fps) : -1,
+                               std::memory_order_relaxed);
+}
+
+void MotionConsumer::setPreviewRate(double fps) {
+    preview_interval_ms_.store(fps > 0 ? static_cast<int64_t>(1000.0 / fps) : -1,
+                               std::memory_order_relaxed);
+}
@@ -1,114 +1,795 @@
 #include "core/motion_detector.hpp"
+#include "core/motion_kernels.hpp"
 #include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
 #include "models/motion_event.hpp"
 
 MotionDetector::MotionDetector(): MotionDetector(Config{}) {}
-MotionDetector::MotionDetector(const Config& cfg) : config_(cfg) {}
+MotionDetector::MotionDetector(const Config& cfg)
+    : config_(cfg)
+    , dilate_kernel_(cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5))) {
+    syncRois();
+}
 
 void MotionDetector::setROI(const ROIConfig& roi) {
     config_.roi = roi;
-    initialized_ = false;
+    config_.rois.clear();
+    syncRois();
+    resetRois();
+}
+
+void MotionDetector::syncRois() {
+    if (config_.rois.empty()) {
+        roi_configs_.assign(1, config_.roi);
+    } else {
+        roi_configs_ = config_.rois;
+    }
 }
 
 MotionEvent MotionDetector::process(const cv::Mat& frame, uint64_t id, int64_t ts) {
-    cv::Rect roi_rect = config_.roi.toRect(frame.cols, frame.rows);
+    boxes_.clear();
+    events_.clear();
+    stats_ = FrameStats();
+    layoutRois(frame.cols, frame.rows);
+    stage_timer_.start();
+
+    // Shared preprocessing over the union of all ROIs
+    cv::cvtColor(frame(union_rect_), gray_, cv::COLOR_BGR2GRAY);
+    endStage(CONVERT);
+    downscale(gray_);
+    const cv::Mat& small = (scale_x_ < 1.0 || scale_y_ < 1.0) ? small_ : gray_;
+    endStage(DOWNSCALE);
+
+    // Keep the blur footprint constant in full-resolution pixels
+    int blur = std::max(3, static_cast<int>(config_.blur_kernel * std::min(scale_x_, scale_y_)) | 1);
+    layoutStrips(small.rows);
+    if (strips_.size() > 1) {
+        blurStrips(small, blur);
+    } else {
+        cv::GaussianBlur(small, blurred_, cv::Size(blur, blur), 0);
+    }
+    endStage(BLUR);
+
+    const cv::Rect bounds(0, 0, blurred_.cols, blurred_.rows);
+    for (RoiState& roi : rois_) {
+        roi.local = localRect(roi.rect, scale_x_, scale_y_, bounds);
+    }
+
+    input_size_ = frame.size();
+    if (!pending_.models.empty()) adoptSnapshot(frame.size());
+    if (config_.full_frame_background) refreshFrameBackground(frame);
+
+    for (size_t i = 0; i < rois_.size(); ++i) {
+        events_.push_back(detectRoi(i, id, ts, frame.rows * frame.cols));
+    }
+    recordStages();
+    countScratchAllocations();
+
+    return events_.front();
+}
+
+void MotionDetector::enableMetrics(const std::string& labels) {
+    static const char* const kStageNames[kStageCount] = {
+        "convert", "downscale", "blur", "diff", "tiles", "morphology", "labeling", "update"
+    };
+    std::string prefix = labels.empty() ? labels : labels + ",";
+    for (int s = 0; s < kStageCount; ++s) {
+        stage_hist_[s] = &MetricsRegistry::global().histogram("motion_stage_seconds",
+            "Time per frame in each MotionDetector::process stage (update is in diff when fused)",
+            prefix + "stage=\"" + kStageNames[s] + "\"");
+    }
+}
 
-    MotionEvent event{id, ts, 0.0, 0, cv::Rect(), roi_rect};
+void MotionDetector::recordStages() {
+    for (int s = 0; s < kStageCount; ++s) {
+        if (stage_hist_[s]) stage_hist_[s]->record(stage_ns_[s]);
+        stage_ns_[s] = 0;
+    }
+}
+
+/** Maps the configured ROIs onto this frame size and their union */
+void MotionDetector::layoutRois(int frame_width, int frame_height) {
+    const std::vector<ROIConfig>& rois = roi_configs_;
+    rois_.resize(rois.size());
+    union_rect_ = cv::Rect();
+    for (size_t i = 0; i < rois.size(); ++i) {
+        rois_[i].rect = rois[i].toRect(frame_width, frame_height);
+        union_rect_ = i == 0 ? rois_[i].rect : (union_rect_ | rois_[i].rect);
+    }
+}
 
-    cv::Mat roi_frame = frame(roi_rect);
+MotionEvent MotionDetector::detectRoi(size_t index, uint64_t id, int64_t ts, int frame_area) {
+    RoiState& roi = rois_[index];
+    const ROIConfig& roi_cfg = roi_configs_[index];
+    const int threshold = roi_cfg.threshold >= 0 ? roi_cfg.threshold : config_.threshold;
+    const int min_area = roi_cfg.min_contour_area >= 0
+        ? roi_cfg.min_contour_area : config_.min_contour_area;
 
-    cv::Mat gray, blurred;
-    cv::cvtColor(roi_frame, gray, cv::COLOR_BGR2GRAY);
-    cv::GaussianBlur(gray, blurred, cv::Size(config_.blur_kernel, config_.blur_kernel), 0);
+    MotionEvent event{id, ts, 0.0, 0, cv::Rect(), roi.rect, static_cast<int>(index)};
+    cv::Mat blurred = blurred_(roi.local);
 
-    if (!initialized_ || 
-        background_.rows != blurred.rows || 
-        background_.cols != blurred.cols) {
-        blurred.convertTo(background_, CV_32F);
-        initialized_ = true;
-        last_viz_ = frame.clone();
-        if (config_.draw_roi) {
-            cv::rectangle(last_viz_, roi_rect, cv::Scalar(255, 0, 0), 2);
+    if (roi.initialized && roi.model_rect == roi.rect && !roi.background.empty() &&
+        roi.background.type() == backgroundType() && roi.background.size() != blurred.size()) {
+        // Only the processing scale changed (e.g. a load governor step):
+        // resample the model instead of re-learning it from one frame
+        cv::Mat resized;
+        cv::resize(roi.background, resized, blurred.size(), 0, 0, cv::INTER_LINEAR);
+        roi.background = resized;
+    }
+    if (!roi.initialized ||
+        roi.background.rows != blurred.rows ||
+        roi.background.cols != blurred.cols ||
+        roi.background.type() != backgroundType()) {
+        bool seeded = seedFromFrameBackground(roi, blurred.size());
+        if (!seeded) {
+            blurred.convertTo(roi.background, backgroundType(), config_.fixed_point ? 256.0 : 1.0);
         }
-        return event;
-    }
-    
-    cv::Mat bg_8u, diff, thresh;
-    background_.convertTo(bg_8u, CV_8U);
-    cv::absdiff(blurred, bg_8u, diff);
-    cv::threshold(diff, thresh, config_.threshold, 255, cv::THRESH_BINARY);
-
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5));
-    cv::dilate(thresh, thresh, kernel, cv::Point(-1,-1), 2);
-
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(thresh, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-    last_viz_ = frame.clone();
-    double max_area = 0, total_area = 0;
-    
-    for (const auto& contour : contours) {
-        double area = cv::contourArea(contour);
-        if (area < config_.min_contour_area) continue;
-        
+        roi.model_rect = roi.rect;
+        roi.initialized = true;
+        endStage(UPDATE);
+        if (!seeded) return event;
+    }
+
+    layoutStrips(blurred.rows);
+    const bool strips = strips_.size() > 1;
+    int changed = -1;  // unknown on the unfused path
+    if (strips && (config_.fused_kernel || config_.fixed_point)) {
+        changed = diffStrips(roi, blurred, threshold);
+    } else if (config_.fused_kernel || config_.fixed_point) {
+        // Diff against the background, threshold and update in one sweep
+        changed = fusedDiffThresholdUpdate(blurred, roi.background, roi.thresh,
+                                           threshold, config_.learning_rate);
+    } else {
+        roi.background.convertTo(bg_8u_, CV_8U);
+        cv::absdiff(blurred, bg_8u_, diff_);
+        cv::threshold(diff_, roi.thresh, threshold, 255, cv::THRESH_BINARY);
+    }
+    endStage(DIFF);
+
+    if (strips) {
+        extractBlobsStrips(roi, changed);
+    } else {
+        extractBlobs(roi, changed);
+    }
+
+    // Whole-ROI, tiled and strip passes label in different orders; a fixed
+    // order keeps boxes and largest_bbox ties identical between them
+    std::sort(blobs_.begin(), blobs_.end(), [](const Blob& a, const Blob& b) {
+        return std::tie(a.box.y, a.box.x, a.box.height, a.box.width, a.area) <
+               std::tie(b.box.y, b.box.x, b.box.height, b.box.width, b.area);
+    });
+
+    double max_area = 0;
+    int64_t total_pixels = 0;  // summed as integers: exact in any order
+    const double area_scale = 1.0 / (scale_x_ * scale_y_);
+
+    for (const Blob& blob : blobs_) {
+        double area = blob.area * area_scale;
+        if (area < min_area) continue;
+
         event.contour_count++;
-        total_area += area;
-
-        cv::Rect bbox = cv::boundingRect(contour);
-        bbox.x += roi_rect.x;
-        bbox.y += roi_rect.y;
-        
-        cv::rectangle(last_viz_, bbox, cv::Scalar(0, 255, 0), 2);
-        
+        total_pixels += blob.area;
+
+        cv::Rect bbox = toFullFrame(blob.box + roi.local.tl(), roi.rect);
+        boxes_.push_back(bbox);
+
         if (area > max_area) {
             max_area = area;
             event.largest_bbox = bbox;
         }
     }
 
-    if (config_.draw_roi) {
-        cv::rectangle(last_viz_, roi_rect, cv::Scalar(255, 0, 0), 2);
-        cv::putText(last_viz_, "ROI", cv::Point(roi_rect.x + 5, roi_rect.y + 20),
-            cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 0, 0), 1);
+    if (config_.refine && event.contour_count > 0) {
+        event.largest_bbox = refineBox(event.largest_bbox, roi, threshold);
     }
+    endStage(LABELING);
 
-    double roi_area = roi_rect.width * roi_rect.height;
-    event.motion_score = (total_area / (frame.rows * frame.cols)) * 100.0;
-    
-    cv::Mat blurred_f;
-    blurred.convertTo(blurred_f, CV_32F);
-    cv::accumulateWeighted(blurred_f, background_, config_.learning_rate);
-    
-    history_.push_back(event);
+    event.motion_score = (total_pixels * area_scale / frame_area) * 100.0;
+
+    if (!config_.fused_kernel && !config_.fixed_point) {
+        blurred.convertTo(blurred_f_, CV_32F);
+        cv::accumulateWeighted(blurred_f_, roi.background, config_.learning_rate);
+        endStage(UPDATE);
+    }
     return event;
 }
-cv::Mat MotionDetector::getVisualization() const { return last_viz_; }
+
+/**
+ * Dilates the threshold mask in place and collects its 8-connected
+ * components into blobs_. With tile gating, both stages run only on the
+ * dirty regions; a static frame skips them entirely.
+ */
+void MotionDetector::extractBlobs(RoiState& roi, int changed) {
+    blobs_.clear();
+    cv::Mat& mask = roi.thresh;
+    roi.labels.create(mask.size(), CV_32SC1);
+    if (config_.tile_size <= 0) {
+        cv::dilate(mask, mask, dilate_kernel_, cv::Point(-1,-1), kDilateIterations);
+        endStage(MORPHOLOGY);
+        labelBlobs(mask, roi.labels, cv::Point());
+        endStage(LABELING);
+        return;
+    }
+
+    findDirtyRegions(mask, changed);
+    endStage(TILES);
+    for (const cv::Rect& region : regions_) {
+        // Isolated: the border must not read a neighbouring region that
+        // has already been dilated in place
+        cv::Mat sub = mask(region);
+        cv::dilate(sub, sub, dilate_kernel_, cv::Point(-1,-1), kDilateIterations,
+                   cv::BORDER_CONSTANT | cv::BORDER_ISOLATED);
+        endStage(MORPHOLOGY);
+        cv::Mat labels = roi.labels(region);
+        labelBlobs(sub, labels, region.tl());
+        endStage(LABELING);
+    }
+}
+
+/** Appends the components of mask to blobs_, shifted by offset */
+void MotionDetector::labelBlobs(const cv::Mat& mask, cv::Mat& labels, const cv::Point& offset) {
+    // OpenCV allocates the stats rows and its label tables on every call
+    int n = cv::connectedComponentsWithStats(mask, labels, cc_stats_, cc_centroids_, 8, CV_32S);
+    for (int label = 1; label < n; ++label) {
+        const int* st = cc_stats_.ptr<int>(label);
+        blobs_.push_back({cv::Rect(st[cv::CC_STAT_LEFT] + offset.x, st[cv::CC_STAT_TOP] + offset.y,
+                                   st[cv::CC_STAT_WIDTH], st[cv::CC_STAT_HEIGHT]),
+                          st[cv::CC_STAT_AREA]});
+    }
+}
+
+/** Splits rows into Config::strips strips of at least kMinStripRows */
+void MotionDetector::layoutStrips(int rows) {
+    int count = std::max(1, std::min(config_.strips, rows / kMinStripRows));
+    strips_.resize(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        strips_[i].y0 = static_cast<int>(static_cast<int64_t>(rows) * i / count);
+        strips_[i].y1 = static_cast<int>(static_cast<int64_t>(rows) * (i + 1) / count);
+    }
+}
+
+void MotionDetector::forEachStrip(size_t count, const std::function<void(size_t)>& fn) {
+    if (pool_) {
+        pool_->parallelFor(count, fn);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) fn(i);
+}
+
+/**
+ * Blurs each strip from its rows plus the kernel radius above and below,
+ * so every output row sees the same input as a whole-image blur.
+ */
+void MotionDetector::blurStrips(const cv::Mat& small, int blur) {
+    blurred_.create(small.size(), CV_8UC1);
+    const int pad = blur / 2;
+    forEachStrip(strips_.size(), [&](size_t i) {
+        Strip& strip = strips_[i];
+        const int py0 = std::max(0, strip.y0 - pad);
+        const int py1 = std::min(small.rows, strip.y1 + pad);
+        cv::GaussianBlur(small.rowRange(py0, py1), strip.blur, cv::Size(blur, blur), 0);
+        cv::Mat rows = blurred_.rowRange(strip.y0, strip.y1);
+        strip.blur.rowRange(strip.y0 - py0, strip.y1 - py0).copyTo(rows);
+    });
+}
+
+/** Fused diff/threshold/update per strip; pixels are independent */
+int MotionDetector::diffStrips(RoiState& roi, const cv::Mat& blurred, int threshold) {
+    roi.thresh.create(blurred.size(), CV_8UC1);
+    forEachStrip(strips_.size(), [&](size_t i) {
+        Strip& strip = strips_[i];
+        cv::Mat background = roi.background.rowRange(strip.y0, strip.y1);
+        cv::Mat mask = roi.thresh.rowRange(strip.y0, strip.y1);
+        strip.changed = fusedDiffThresholdUpdate(blurred.rowRange(strip.y0, strip.y1),
+                                                 background, mask, threshold,
+                                                 config_.learning_rate);
+    });
+    int changed = 0;
+    for (const Strip& strip : strips_) changed += strip.changed;
+    return changed;
+}
+
+/**
+ * Strip-parallel extractBlobs. Each strip dilates its rows plus the
+ * dilation reach into scratch (neighbours still read the undilated mask),
+ * then writes its rows back and labels them. Components cut by strip
+ * edges are joined in mergeStripBlobs().
+ */
+void MotionDetector::extractBlobsStrips(RoiState& roi, int changed) {
+    blobs_.clear();
+    cv::Mat& mask = roi.thresh;
+    if (changed == 0) return;  // static frame
+
+    const int reach = kDilateIterations * (dilate_kernel_.rows / 2);
+    forEachStrip(strips_.size(), [&](size_t i) {
+        Strip& strip = strips_[i];
+        const int py0 = std::max(0, strip.y0 - reach);
+        const int py1 = std::min(mask.rows, strip.y1 + reach);
+        strip.components = 0;
+        // Nothing within reach: the strip stays empty after dilation too
+        strip.changed = cv::countNonZero(mask.rowRange(py0, py1));
+        if (strip.changed == 0) return;
+        cv::dilate(mask.rowRange(py0, py1), strip.dilated, dilate_kernel_,
+                   cv::Point(-1,-1), kDilateIterations);
+    });
+    endStage(MORPHOLOGY);
+
+    roi.labels.create(mask.size(), CV_32SC1);
+    forEachStrip(strips_.size(), [&](size_t i) {
+        Strip& strip = strips_[i];
+        if (strip.changed == 0) return;
+        const int py0 = std::max(0, strip.y0 - reach);
+        cv::Mat rows = mask.rowRange(strip.y0, strip.y1);
+        strip.dilated.rowRange(strip.y0 - py0, strip.y1 - py0).copyTo(rows);
+        cv::Mat labels = roi.labels.rowRange(strip.y0, strip.y1);
+        strip.components = cv::connectedComponentsWithStats(rows, labels, strip.stats,
+                                                            strip.centroids, 8, CV_32S);
+    });
+    mergeStripBlobs(roi, strips_.size());
+    endStage(LABELING);
+}
+
+/**
+ * Joins strip components that touch across a strip edge (8-connected:
+ * the row above and the three pixels below it) with union-find, then
+ * folds their stats into one blob per root.
+ */
+void MotionDetector::mergeStripBlobs(const RoiState& roi, size_t count) {
+    int total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        strips_[i].base = total;
+        total += std::max(0, strips_[i].components - 1);
+    }
+    blob_parent_.resize(static_cast<size_t>(total));
+    std::iota(blob_parent_.begin(), blob_parent_.end(), 0);
+    auto find = [this](int x) {
+        while (blob_parent_[x] != x) {
+            blob_parent_[x] = blob_parent_[blob_parent_[x]];
+            x = blob_parent_[x];
+        }
+        return x;
+    };
+
+    const int cols = roi.labels.cols;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        const Strip& upper = strips_[i];
+        const Strip& lower = strips_[i + 1];
+        if (upper.components <= 1 || lower.components <= 1) continue;
+        const int* above = roi.labels.ptr<int>(upper.y1 - 1);
+        const int* below = roi.labels.ptr<int>(lower.y0);
+        for (int x = 0; x < cols; ++x) {
+            if (!above[x]) continue;
+            for (int nx = std::max(0, x - 1); nx <= std::min(cols - 1, x + 1); ++nx) {
+                if (!below[nx]) continue;
+                int a = find(upper.base + above[x] - 1);
+                int b = find(lower.base + below[nx] - 1);
+                if (a != b) blob_parent_[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    blob_slot_.assign(static_cast<size_t>(total), -1);
+    for (size_t i = 0; i < count; ++i) {
+        const Strip& strip = strips_[i];
+        for (int label = 1; label < strip.components; ++label) {
+            const int* st = strip.stats.ptr<int>(label);
+            Blob piece{cv::Rect(st[cv::CC_STAT_LEFT], st[cv::CC_STAT_TOP] + strip.y0,
+                                st[cv::CC_STAT_WIDTH], st[cv::CC_STAT_HEIGHT]),
+                       st[cv::CC_STAT_AREA]};
+            int& slot = blob_slot_[find(strip.base + label - 1)];
+            if (slot < 0) {
+                slot = static_cast<int>(blobs_.size());
+                blobs_.push_back(piece);
+            } else {
+                blobs_[slot].box |= piece.box;
+                blobs_[slot].area += piece.area;
+            }
+        }
+    }
+}
+
+/**
+ * Marks tiles holding any set mask pixel, groups 8-connected dirty tiles
+ * and grows each group by the dilation reach plus one pixel. Groups whose
+ * grown rects overlap are merged, so every region holds whole dilated
+ * blobs and, dilated with an isolated border, regions never interact:
+ * components match a full-ROI pass.
+ */
+void MotionDetector::findDirtyRegions(const cv::Mat& mask, int changed) {
+    regions_.clear();
+    const int ts = config_.tile_size;
+    const int gw = (mask.cols + ts - 1) / ts;
+    const int gh = (mask.rows + ts - 1) / ts;
+    stats_.tiles_total += gw * gh;
+    if (changed == 0) return;  // static frame: nothing to look at
+
+    tiles_.assign(static_cast<size_t>(gw) * gh, 0);
+    int dirty = 0;
+    for (int ty = 0; ty < gh; ++ty) {
+        for (int tx = 0; tx < gw; ++tx) {
+            cv::Rect tile(tx * ts, ty * ts, std::min(ts, mask.cols - tx * ts),
+                          std::min(ts, mask.rows - ty * ts));
+            if (cv::countNonZero(mask(tile)) > 0) {
+                tiles_[ty * gw + tx] = 1;
+                ++dirty;
+            }
+        }
+    }
+    stats_.tiles_dirty += dirty;
+    if (dirty == 0) return;
+
+    const int halo = kDilateIterations * (dilate_kernel_.cols / 2) + 1;
+    const cv::Rect bounds(0, 0, mask.cols, mask.rows);
+    for (int start = 0; start < gw * gh; ++start) {
+        if (tiles_[start] != 1) continue;
+        // Flood fill one group, tracking its tile bounding box
+        int x0 = gw, y0 = gh, x1 = -1, y1 = -1;
+        tiles_[start] = 2;
+        tile_stack_.assign(1, start);
+        while (!tile_stack_.empty()) {
+            int t = tile_stack_.back();
+            tile_stack_.pop_back();
+            int tx = t % gw, ty = t / gw;
+            x0 = std::min(x0, tx); x1 = std::max(x1, tx);
+            y0 = std::min(y0, ty); y1 = std::max(y1, ty);
+            for (int ny = std::max(0, ty - 1); ny <= std::min(gh - 1, ty + 1); ++ny) {
+                for (int nx = std::max(0, tx - 1); nx <= std::min(gw - 1, tx + 1); ++nx) {
+                    int n = ny * gw + nx;
+                    if (tiles_[n] == 1) {
+                        tiles_[n] = 2;
+                        tile_stack_.push_back(n);
+                    }
+                }
+            }
+        }
+        cv::Rect group(x0 * ts - halo, y0 * ts - halo,
+                       (x1 - x0 + 1) * ts + 2 * halo, (y1 - y0 + 1) * ts + 2 * halo);
+        regions_.push_back(group & bounds);
+    }
+
+    // Merge until disjoint; merging can create new overlaps, so repeat
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < regions_.size() && !merged; ++i) {
+            for (size_t j = i + 1; j < regions_.size(); ++j) {
+                if ((regions_[i] & regions_[j]).empty()) continue;
+                regions_[i] |= regions_[j];
+                regions_.erase(regions_.begin() + j);
+                merged = true;
+                break;
+            }
+        }
+    }
+    stats_.regions += static_cast<int>(regions_.size());
+}
+
+void MotionDetector::countScratchAllocations() {
+    const cv::Mat* scratch[kScratchCount] = {
+        &gray_, &small_, &blurred_, &bg_8u_, &diff_, &blurred_f_
+    };
+    for (size_t i = 0; i < kScratchCount; ++i) {
+        const uchar* data = scratch[i]->datastart;
+        if (data != scratch_data_[i]) {
+            if (data) ++allocations_;
+            scratch_data_[i] = data;
+        }
+    }
+    for (RoiState& roi : rois_) {
+        if (roi.thresh.datastart != roi.thresh_data) {
+            if (roi.thresh.datastart) ++allocations_;
+            roi.thresh_data = roi.thresh.datastart;
+        }
+    }
+}
+
+/** rect (full frame) in processing coordinates of the ROI union */
+cv::Rect MotionDetector::localRect(const cv::Rect& rect, double sx, double sy,
+                                   const cv::Rect& bounds) const {
+    int x0 = static_cast<int>(std::floor((rect.x - union_rect_.x) * sx));
+    int y0 = static_cast<int>(std::floor((rect.y - union_rect_.y) * sy));
+    int x1 = static_cast<int>(std::ceil((rect.br().x - union_rect_.x) * sx));
+    int y1 = static_cast<int>(std::ceil((rect.br().y - union_rect_.y) * sy));
+    return cv::Rect(x0, y0, std::max(1, x1 - x0), std::max(1, y1 - y0)) & bounds;
+}
+
+/** Size downscale() produces from a size x gray image under cfg */
+cv::Size MotionDetector::processingSize(const Config& cfg, const cv::Size& size) {
+    if (cfg.pyramid_levels > 0) {
+        cv::Size s = size;
+        for (int level = 0; level < cfg.pyramid_levels && s.width > 1 && s.height > 1; ++level) {
+            s = cv::Size((s.width + 1) / 2, (s.height + 1) / 2);
+        }
+        return s;
+    }
+    if (cfg.process_scale > 0.0 && cfg.process_scale < 1.0) {
+        return cv::Size(std::max(1, static_cast<int>(size.width * cfg.process_scale)),
+                        std::max(1, static_cast<int>(size.height * cfg.process_scale)));
+    }
+    return size;
+}
+
+/** Shrinks the gray ROI into small_ and records the effective scale */
+void MotionDetector::downscale(const cv::Mat& gray) {
+    scale_x_ = scale_y_ = 1.0;
+    if (config_.pyramid_levels > 0) {
+        const cv::Mat* src = &gray;
+        for (int level = 0; level < config_.pyramid_levels && src->rows > 1 && src->cols > 1; ++level) {
+            cv::Mat& dst = (level % 2 == config_.pyramid_levels % 2) ? pyr_tmp_ : small_;
+            cv::pyrDown(*src, dst);
+            src = &dst;
+        }
+        if (src != &small_) src->copyTo(small_);
+    } else if (config_.process_scale > 0.0 && config_.process_scale < 1.0) {
+        cv::Size size(std::max(1, static_cast<int>(gray.cols * config_.process_scale)),
+                      std::max(1, static_cast<int>(gray.rows * config_.process_scale)));
+        cv::resize(gray, small_, size, 0, 0, cv::INTER_AREA);
+    } else {
+        return;
+    }
+    scale_x_ = static_cast<double>(small_.cols) / gray.cols;
+    scale_y_ = static_cast<double>(small_.rows) / gray.rows;
+}
+
+/**
+ * Maps a rect in processing coordinates (relative to the ROI union) to
+ * full-frame coordinates, clipped to clip
+ */
+cv::Rect MotionDetector::toFullFrame(const cv::Rect& r, const cv::Rect& clip) const {
+    int x0 = static_cast<int>(std::floor(r.x / scale_x_));
+    int y0 = static_cast<int>(std::floor(r.y / scale_y_));
+    int x1 = static_cast<int>(std::ceil((r.x + r.width) / scale_x_));
+    int y1 = static_cast<int>(std::ceil((r.y + r.height) / scale_y_));
+    cv::Rect full(x0 + union_rect_.x, y0 + union_rect_.y, x1 - x0, y1 - y0);
+    return full & clip;
+}
+
+/**
+ * Full-resolution pass over one coarse box: blur the gray crop, diff it
+ * against the upsampled background and shrink the box to the pixels that
+ * actually changed. Keeps the coarse box if nothing survives.
+ */
+cv::Rect MotionDetector::refineBox(const cv::Rect& box, const RoiState& roi, int threshold) {
+    if (scale_x_ >= 1.0 && scale_y_ >= 1.0) return box;
+
+    cv::Rect local(box.x - union_rect_.x, box.y - union_rect_.y, box.width, box.height);
+    local &= cv::Rect(0, 0, gray_.cols, gray_.rows);
+    if (local.empty()) return box;
+
+    cv::Rect bg_rect(static_cast<int>(std::floor(local.x * scale_x_)) - roi.local.x,
+                     static_cast<int>(std::floor(local.y * scale_y_)) - roi.local.y,
+                     std::max(1, static_cast<int>(std::ceil(local.width * scale_x_))),
+                     std::max(1, static_cast<int>(std::ceil(local.height * scale_y_))));
+    bg_rect &= cv::Rect(0, 0, roi.background.cols, roi.background.rows);
+    if (bg_rect.empty()) return box;
+
+    int k = config_.blur_kernel | 1;
+    cv::GaussianBlur(gray_(local), refine_blur_, cv::Size(k, k), 0);
+    cv::resize(roi.background(bg_rect), refine_bg_, local.size(), 0, 0, cv::INTER_LINEAR);
+    refine_bg_.convertTo(refine_mask_, CV_8U, config_.fixed_point ? 1.0 / 256.0 : 1.0);
+    cv::absdiff(refine_blur_, refine_mask_, refine_mask_);
+    cv::threshold(refine_mask_, refine_mask_, threshold, 255, cv::THRESH_BINARY);
+
+    cv::Rect tight = cv::boundingRect(refine_mask_);
+    if (tight.empty()) return box;
+    return cv::Rect(tight.x + local.x + union_rect_.x, tight.y + local.y + union_rect_.y,
+                    tight.width, tight.height);
+}
+
+void MotionDetector::motionMask(cv::Mat& out) const {
+    out.create(blurred_.size(), CV_8UC1);
+    out.setTo(cv::Scalar(0));
+    for (const RoiState& roi : rois_) {
+        // Skips ROIs that only initialized their background this frame
+        if (roi.thresh.size() != roi.local.size()) continue;
+        cv::Mat dst = out(roi.local);
+        cv::bitwise_or(dst, roi.thresh, dst);
+    }
+}
 
 void MotionDetector::setConfig(const Config& cfg) {
-    bool roi_changed = (config_.roi.center_x != cfg.roi.center_x ||
-                        config_.roi.center_y != cfg.roi.center_y ||
-                        config_.roi.width_ratio != cfg.roi.width_ratio ||
-                        config_.roi.height_ratio != cfg.roi.height_ratio);
-    
+    std::vector<ROIConfig> old_rois = std::move(roi_configs_);
     config_ = cfg;
-    
-    if (roi_changed) {
-        resetBackground();
+    syncRois();
+
+    // Only ROIs whose geometry changed re-learn their background
+    rois_.resize(roi_configs_.size());
+    for (size_t i = 0; i < roi_configs_.size(); ++i) {
+        if (i >= old_rois.size() || !old_rois[i].sameGeometry(roi_configs_[i])) {
+            rois_[i] = RoiState();
+        }
     }
+    if (!config_.full_frame_background) frame_bg_.release();
+}
+
+void MotionDetector::resetRois() {
+    for (RoiState& roi : rois_) roi = RoiState();
 }
 
 void MotionDetector::resetBackground() {
-    initialized_ = false;
-    background_.release();
+    resetRois();
+    frame_bg_.release();
+    pending_ = BackgroundSnapshot();
+    restored_storage_.clear();
+}
+
+void MotionDetector::snapshotBackground(BackgroundSnapshot& out, const Config* as) const {
+    const Config& target = as ? *as : config_;
+    out.frame_size = input_size_;
+    out.type = backgroundType();
+    // Resampling changes the scale, not the blur the models were learned at
+    out.blur_kernel = config_.blur_kernel;
+    out.process_scale = target.process_scale;
+    out.pyramid_levels = target.pyramid_levels;
+
+    // Processing scale of target, as process() would derive it
+    double sx = scale_x_, sy = scale_y_;
+    cv::Rect bounds;
+    const bool resample = !union_rect_.empty() &&
+                          (target.process_scale != config_.process_scale ||
+                           target.pyramid_levels != config_.pyramid_levels);
+    if (resample) {
+        bounds = cv::Rect(cv::Point(), processingSize(target, union_rect_.size()));
+        sx = static_cast<double>(bounds.width) / union_rect_.width;
+        sy = static_cast<double>(bounds.height) / union_rect_.height;
+    }
+
+    size_t count = 0;
+    auto add = [&](BackgroundSnapshot::Kind kind, int index, const cv::Rect& rect,
+                   const cv::Mat& background, const cv::Size& size) {
+        if (out.models.size() <= count) out.models.emplace_back();
+        BackgroundSnapshot::Model& model = out.models[count++];
+        model.kind = kind;
+        model.index = index;
+        model.rect = rect;
+        if (size == background.size()) {
+            background.copyTo(model.background);  // same size: no reallocation
+        } else {
+            cv::resize(background, model.background, size, 0, 0, cv::INTER_LINEAR);
+        }
+    };
+    for (size_t i = 0; i < rois_.size(); ++i) {
+        const RoiState& roi = rois_[i];
+        if (!roi.initialized || roi.background.empty()) continue;
+        cv::Size size = resample ? localRect(roi.rect, sx, sy, bounds).size()
+                                 : roi.background.size();
+        add(BackgroundSnapshot::ROI, static_cast<int>(i), roi.rect, roi.background, size);
+    }
+    if (!frame_bg_.empty()) {
+        cv::Size size = resample
+            ? cv::Size(std::max(1, static_cast<int>(std::lround(frame_size_.width * sx))),
+                       std::max(1, static_cast<int>(std::lround(frame_size_.height * sy))))
+            : frame_bg_.size();
+        add(BackgroundSnapshot::FRAME, 0, cv::Rect(cv::Point(), frame_size_), frame_bg_, size);
+    }
+    out.models.resize(count);
 }
 
-void MotionDetector::exportCSV(const std::string& path) const {
-    std::ofstream file(path);
-    file << "frame_id,timestamp_ms,motion_score,contour_count\n";
-    for (const auto& e : history_) {
-        file << e.frame_id << "," << e.timestamp_ms << ","
-             << e.motion_score << "," << e.contour_count << ","
-             << e.roi_used.x << "," << e.roi_used.y << ","
-             << e.roi_used.width << "," << e.roi_used.height << "\n";
+void MotionDetector::restoreBackground(BackgroundSnapshot&& snapshot) {
+    pending_ = std::move(snapshot);
+    restored_models_ = 0;
+}
+
+/**
+ * Moves the pending models that fit this frame into place (no copy). Runs
+ * after layout, so ROI rects and processing sizes are final; a model from
+ * another resolution, ROI or scale is dropped.
+ */
+void MotionDetector::adoptSnapshot(const cv::Size& frame_size) {
+    BackgroundSnapshot snapshot = std::move(pending_);
+    pending_ = BackgroundSnapshot();
+    if (snapshot.frame_size != frame_size || snapshot.type != backgroundType() ||
+        snapshot.blur_kernel != config_.blur_kernel ||
+        snapshot.process_scale != config_.process_scale ||
+        snapshot.pyramid_levels != config_.pyramid_levels) {
+        return;
+    }
+    for (BackgroundSnapshot::Model& model : snapshot.models) {
+        if (model.background.type() != backgroundType()) continue;
+        if (model.kind == BackgroundSnapshot::FRAME) {
+            // refreshFrameBackground() rebuilds it unless the size matches
+            if (!config_.full_frame_background) continue;
+            frame_bg_ = std::move(model.background);
+            frame_size_ = frame_size;
+            refresh_band_ = 0;
+            ++restored_models_;
+            continue;
+        }
+        if (model.index < 0 || static_cast<size_t>(model.index) >= rois_.size()) continue;
+        RoiState& roi = rois_[model.index];
+        if (roi.rect != model.rect || model.background.size() != roi.local.size()) continue;
+        roi.background = std::move(model.background);
+        roi.model_rect = roi.rect;
+        roi.initialized = true;
+        ++restored_models_;
+    }
+    if (restored_models_ > 0 && snapshot.storage) restored_storage_.push_back(snapshot.storage);
+}
+
+/**
+ * Runs the shared preprocessing over one band of the frame and folds it
+ * into frame_bg_. The band is padded by the blur radius so its edges
+ * match a whole-frame blur. Bands cycle over the frame; each is updated
+ * every refresh_bands frames with the rate compounded to match, so the
+ * model follows the scene as fast as a per-frame update would. On the
+ * first frame (or a geometry change) the whole frame is one band.
+ */
+void MotionDetector::refreshFrameBackground(const cv::Mat& frame) {
+    const double sx = scale_x_, sy = scale_y_;
+    const cv::Size size(std::max(1, static_cast<int>(std::lround(frame.cols * sx))),
+                        std::max(1, static_cast<int>(std::lround(frame.rows * sy))));
+    if (!frame_bg_.empty() && frame_bg_.size() != size && frame_size_ == frame.size() &&
+        frame_bg_.type() == backgroundType()) {
+        // Only the processing scale changed: resample instead of rebuilding
+        cv::Mat resized;
+        cv::resize(frame_bg_, resized, size, 0, 0, cv::INTER_LINEAR);
+        frame_bg_ = resized;
+    }
+    bool rebuild = frame_bg_.empty() || frame_bg_.size() != size ||
+                   frame_bg_.type() != backgroundType() || frame_size_ != frame.size();
+    frame_size_ = frame.size();
+
+    const int bands = std::max(1, config_.refresh_bands);
+    // Band height in whole tiles, so refresh follows the gating grid
+    const int tile = std::max(1, config_.tile_size);
+    const int band_rows = std::max(tile, (size.height + bands - 1) / bands / tile * tile);
+    int y0 = 0, y1 = size.height;
+    double alpha = 1.0;
+    if (rebuild) {
+        frame_bg_.create(size, backgroundType());
+        refresh_band_ = 0;
+    } else {
+        int count = (size.height + band_rows - 1) / band_rows;
+        refresh_band_ = (refresh_band_ + 1) % count;
+        y0 = refresh_band_ * band_rows;
+        y1 = std::min(size.height, y0 + band_rows);
+        alpha = 1.0 - std::pow(1.0 - config_.learning_rate, count);
+    }
+
+    int blur = std::max(3, static_cast<int>(config_.blur_kernel * std::min(sx, sy)) | 1);
+    const int pad = blur / 2;
+    const int py0 = std::max(0, y0 - pad);
+    const int py1 = std::min(size.height, y1 + pad);
+    const int fy0 = static_cast<int>(std::floor(py0 / sy));
+    const int fy1 = std::min(frame.rows, static_cast<int>(std::ceil(py1 / sy)));
+    cv::cvtColor(frame.rowRange(fy0, fy1), band_gray_, cv::COLOR_BGR2GRAY);
+    if (band_gray_.size() != cv::Size(size.width, py1 - py0)) {
+        cv::resize(band_gray_, band_small_, cv::Size(size.width, py1 - py0), 0, 0, cv::INTER_AREA);
+    } else {
+        band_gray_.copyTo(band_small_);
+    }
+    cv::GaussianBlur(band_small_, band_blur_, cv::Size(blur, blur), 0);
+
+    cv::Mat src = band_blur_.rowRange(y0 - py0, y1 - py0);
+    cv::Mat dst = frame_bg_.rowRange(y0, y1);
+    if (rebuild) {
+        src.convertTo(dst, backgroundType(), config_.fixed_point ? 256.0 : 1.0);
+    } else {
+        fusedDiffThresholdUpdate(src, dst, band_mask_, 255, alpha);
+    }
+    endStage(UPDATE);
+}
+
+/**
+ * Initializes an ROI background from the full-frame model, resampled to
+ * the ROI's processing size. False when there is no model to seed from.
+ */
+bool MotionDetector::seedFromFrameBackground(RoiState& roi, const cv::Size& size) {
+    if (!config_.full_frame_background || frame_bg_.empty() ||
+        frame_bg_.type() != backgroundType()) {
+        return false;
+    }
+    const double fx = static_cast<double>(frame_bg_.cols) / frame_size_.width;
+    const double fy = static_cast<double>(frame_bg_.rows) / frame_size_.height;
+    cv::Rect r(static_cast<int>(std::floor(roi.rect.x * fx)),
+               static_cast<int>(std::floor(roi.rect.y * fy)), size.width, size.height);
+    r &= cv::Rect(0, 0, frame_bg_.cols, frame_bg_.rows);
+    if (r.empty()) return false;
+    if (r.size() == size) {
+        frame_bg_(r).copyTo(roi.background);
+    } else {
+        cv::resize(frame_bg_(r), roi.background, size, 0, 0, cv::INTER_LINEAR);
     }
+    return true;
 }
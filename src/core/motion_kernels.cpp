@@ -0,0 +1,331 @@
+#include "core/motion_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MOTION_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+int fusedScalar(const uint8_t* cur, float* bg, uint8_t* mask,
+                int n, int threshold, float alpha) {
+    const float beta = 1.0f - alpha;
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        // lrint rounds half to even, like cvRound in convertTo
+        int b = static_cast<int>(std::lrint(bg[i]));
+        int d = std::abs(static_cast<int>(cur[i]) - b);
+        uint8_t m = d > threshold ? 255 : 0;
+        mask[i] = m;
+        count += m & 1;
+        bg[i] = bg[i] * beta + static_cast<float>(cur[i]) * alpha;
+    }
+    return count;
+}
+
+int fused16Scalar(const uint8_t* cur, uint16_t* bg, uint8_t* mask,
+                  int n, int threshold, uint16_t alpha) {
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        int b = (bg[i] + 128) >> 8;
+        int d = std::abs(static_cast<int>(cur[i]) - b);
+        uint8_t m = d > threshold ? 255 : 0;
+        mask[i] = m;
+        count += m & 1;
+        // Magnitude and sign apart, as the SIMD paths do with mulhi_epu16
+        int target = cur[i] << 8;
+        uint32_t mag = static_cast<uint32_t>(std::abs(target - bg[i]));
+        uint16_t step = static_cast<uint16_t>((mag * alpha + 32768) >> 16);
+        bg[i] = static_cast<uint16_t>(target >= bg[i] ? bg[i] + step : bg[i] - step);
+    }
+    return count;
+}
+
+#ifdef MOTION_KERNELS_X86
+
+// All comparisons are done on integer-valued floats, which is exact.
+__attribute__((target("sse2")))
+int fusedSSE2(const uint8_t* cur, float* bg, uint8_t* mask,
+              int n, int threshold, float alpha) {
+    const __m128 va = _mm_set1_ps(alpha);
+    const __m128 vb = _mm_set1_ps(1.0f - alpha);
+    const __m128 vt = _mm_set1_ps(static_cast<float>(threshold));
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128i zero = _mm_setzero_si128();
+    int count = 0;
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i c8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+        __m128i c16lo = _mm_unpacklo_epi8(c8, zero);
+        __m128i c16hi = _mm_unpackhi_epi8(c8, zero);
+        __m128i c32[4] = {
+            _mm_unpacklo_epi16(c16lo, zero), _mm_unpackhi_epi16(c16lo, zero),
+            _mm_unpacklo_epi16(c16hi, zero), _mm_unpackhi_epi16(c16hi, zero)
+        };
+        __m128i m32[4];
+        for (int k = 0; k < 4; ++k) {
+            __m128 c = _mm_cvtepi32_ps(c32[k]);
+            __m128 b = _mm_loadu_ps(bg + i + 4 * k);
+            __m128 br = _mm_cvtepi32_ps(_mm_cvtps_epi32(b));
+            __m128 d = _mm_and_ps(_mm_sub_ps(c, br), abs_mask);
+            m32[k] = _mm_castps_si128(_mm_cmpgt_ps(d, vt));
+            _mm_storeu_ps(bg + i + 4 * k, _mm_add_ps(_mm_mul_ps(b, vb), _mm_mul_ps(c, va)));
+        }
+        __m128i m = _mm_packs_epi16(_mm_packs_epi32(m32[0], m32[1]),
+                                    _mm_packs_epi32(m32[2], m32[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), m);
+        count += __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(m)));
+    }
+    return count + fusedScalar(cur + i, bg + i, mask + i, n - i, threshold, alpha);
+}
+
+__attribute__((target("avx2")))
+int fusedAVX2(const uint8_t* cur, float* bg, uint8_t* mask,
+              int n, int threshold, float alpha) {
+    const __m256 va = _mm256_set1_ps(alpha);
+    const __m256 vb = _mm256_set1_ps(1.0f - alpha);
+    const __m256 vt = _mm256_set1_ps(static_cast<float>(threshold));
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    // Undo the per-lane interleaving of packs_epi32 / packs_epi16
+    const __m256i unshuffle = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int count = 0;
+    int i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i m32[4];
+        for (int k = 0; k < 4; ++k) {
+            __m128i c8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cur + i + 8 * k));
+            __m256 c = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(c8));
+            __m256 b = _mm256_loadu_ps(bg + i + 8 * k);
+            __m256 br = _mm256_round_ps(b, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            __m256 d = _mm256_and_ps(_mm256_sub_ps(c, br), abs_mask);
+            m32[k] = _mm256_castps_si256(_mm256_cmp_ps(d, vt, _CMP_GT_OQ));
+            _mm256_storeu_ps(bg + i + 8 * k,
+                _mm256_add_ps(_mm256_mul_ps(b, vb), _mm256_mul_ps(c, va)));
+        }
+        __m256i m = _mm256_packs_epi16(_mm256_packs_epi32(m32[0], m32[1]),
+                                       _mm256_packs_epi32(m32[2], m32[3]));
+        m = _mm256_permutevar8x32_epi32(m, unshuffle);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(mask + i), m);
+        count += __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(m)));
+    }
+    return count + fusedSSE2(cur + i, bg + i, mask + i, n - i, threshold, alpha);
+}
+
+/**
+ * 8.8 update on 16-bit lanes: |target - bg| * alpha >> 16 (rounded) via
+ * mulhi/mullo_epu16, then added or subtracted by the sign of the delta.
+ * The step never exceeds the magnitude, so nothing wraps.
+ */
+__attribute__((target("sse2")))
+int fused16SSE2(const uint8_t* cur, uint16_t* bg, uint8_t* mask,
+                int n, int threshold, uint16_t alpha) {
+    const __m128i va = _mm_set1_epi16(static_cast<short>(alpha));
+    const __m128i vt = _mm_set1_epi16(static_cast<short>(threshold));
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i zero = _mm_setzero_si128();
+    int count = 0;
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i c8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+        __m128i c16[2] = {_mm_unpacklo_epi8(c8, zero), _mm_unpackhi_epi8(c8, zero)};
+        __m128i m16[2];
+        for (int k = 0; k < 2; ++k) {
+            __m128i* p = reinterpret_cast<__m128i*>(bg + i + 8 * k);
+            __m128i b = _mm_loadu_si128(p);
+            __m128i br = _mm_srli_epi16(_mm_add_epi16(b, half), 8);
+            __m128i d = _mm_or_si128(_mm_subs_epu16(c16[k], br), _mm_subs_epu16(br, c16[k]));
+            m16[k] = _mm_cmpgt_epi16(d, vt);
+
+            __m128i target = _mm_slli_epi16(c16[k], 8);
+            __m128i up = _mm_subs_epu16(target, b);
+            __m128i down = _mm_subs_epu16(b, target);
+            __m128i mag = _mm_or_si128(up, down);
+            __m128i step = _mm_add_epi16(_mm_mulhi_epu16(mag, va),
+                                         _mm_srli_epi16(_mm_mullo_epi16(mag, va), 15));
+            // up is zero where target < bg, down is zero otherwise
+            __m128i rising = _mm_cmpeq_epi16(down, zero);
+            b = _mm_add_epi16(b, _mm_and_si128(rising, step));
+            b = _mm_sub_epi16(b, _mm_andnot_si128(rising, step));
+            _mm_storeu_si128(p, b);
+        }
+        __m128i m = _mm_packs_epi16(m16[0], m16[1]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), m);
+        count += __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(m)));
+    }
+    return count + fused16Scalar(cur + i, bg + i, mask + i, n - i, threshold, alpha);
+}
+
+__attribute__((target("avx2")))
+int fused16AVX2(const uint8_t* cur, uint16_t* bg, uint8_t* mask,
+                int n, int threshold, uint16_t alpha) {
+    const __m256i va = _mm256_set1_epi16(static_cast<short>(alpha));
+    const __m256i vt = _mm256_set1_epi16(static_cast<short>(threshold));
+    const __m256i half = _mm256_set1_epi16(128);
+    const __m256i zero = _mm256_setzero_si256();
+    int count = 0;
+    int i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i m16[2];
+        for (int k = 0; k < 2; ++k) {
+            __m128i c8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i + 16 * k));
+            __m256i c = _mm256_cvtepu8_epi16(c8);
+            __m256i* p = reinterpret_cast<__m256i*>(bg + i + 16 * k);
+            __m256i b = _mm256_loadu_si256(p);
+            __m256i br = _mm256_srli_epi16(_mm256_add_epi16(b, half), 8);
+            __m256i d = _mm256_or_si256(_mm256_subs_epu16(c, br), _mm256_subs_epu16(br, c));
+            m16[k] = _mm256_cmpgt_epi16(d, vt);
+
+            __m256i target = _mm256_slli_epi16(c, 8);
+            __m256i down = _mm256_subs_epu16(b, target);
+            __m256i mag = _mm256_or_si256(_mm256_subs_epu16(target, b), down);
+            __m256i step = _mm256_add_epi16(_mm256_mulhi_epu16(mag, va),
+                                            _mm256_srli_epi16(_mm256_mullo_epi16(mag, va), 15));
+            __m256i rising = _mm256_cmpeq_epi16(down, zero);
+            b = _mm256_add_epi16(b, _mm256_and_si256(rising, step));
+            b = _mm256_sub_epi16(b, _mm256_andnot_si256(rising, step));
+            _mm256_storeu_si256(p, b);
+        }
+        // packs works per 128-bit lane; restore element order
+        __m256i m = _mm256_permute4x64_epi64(_mm256_packs_epi16(m16[0], m16[1]), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(mask + i), m);
+        count += __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(m)));
+    }
+    return count + fused16SSE2(cur + i, bg + i, mask + i, n - i, threshold, alpha);
+}
+
+#endif  // MOTION_KERNELS_X86
+
+using FusedFn = int (*)(const uint8_t*, float*, uint8_t*, int, int, float);
+using Fused16Fn = int (*)(const uint8_t*, uint16_t*, uint8_t*, int, int, uint16_t);
+
+struct Dispatch {
+    FusedFn fn;
+    Fused16Fn fn16;
+    const char* name;
+};
+
+Dispatch selectKernel() {
+#ifdef MOTION_KERNELS_X86
+    if (std::getenv("MOTION_FORCE_SCALAR")) return {fusedScalar, fused16Scalar, "scalar"};
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {fusedAVX2, fused16AVX2, "avx2"};
+    if (__builtin_cpu_supports("sse2")) return {fusedSSE2, fused16SSE2, "sse2"};
+#endif
+    return {fusedScalar, fused16Scalar, "scalar"};
+}
+
+const Dispatch& dispatch() {
+    static const Dispatch d = selectKernel();
+    return d;
+}
+
+// Every SIMD path this CPU can run
+std::vector<Dispatch> simdKernels() {
+    std::vector<Dispatch> kernels;
+#ifdef MOTION_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) kernels.push_back({fusedSSE2, fused16SSE2, "sse2"});
+    if (__builtin_cpu_supports("avx2")) kernels.push_back({fusedAVX2, fused16AVX2, "avx2"});
+#endif
+    return kernels;
+}
+
+}  // namespace
+
+int fusedDiffThresholdUpdate(const uint8_t* cur, float* bg, uint8_t* mask,
+                             int n, int threshold, float alpha) {
+    return dispatch().fn(cur, bg, mask, n, threshold, alpha);
+}
+
+int fusedDiffThresholdUpdate16(const uint8_t* cur, uint16_t* bg, uint8_t* mask,
+                               int n, int threshold, uint16_t alpha_q16) {
+    return dispatch().fn16(cur, bg, mask, n, threshold, alpha_q16);
+}
+
+int fusedDiffThresholdUpdate(const cv::Mat& cur, cv::Mat& bg, cv::Mat& mask,
+                             int threshold, double alpha) {
+    CV_Assert(cur.type() == CV_8UC1 && cur.size() == bg.size() &&
+              (bg.type() == CV_32FC1 || bg.type() == CV_16UC1));
+    mask.create(cur.size(), CV_8UC1);
+    const bool fixed = bg.type() == CV_16UC1;
+    const uint16_t alpha_q16 = static_cast<uint16_t>(
+        std::min(65535.0, std::max(0.0, std::round(alpha * 65536.0))));
+
+    int rows = cur.rows;
+    int cols = cur.cols;
+    if (cur.isContinuous() && bg.isContinuous() && mask.isContinuous()) {
+        cols *= rows;
+        rows = 1;
+    }
+    int count = 0;
+    for (int r = 0; r < rows; ++r) {
+        if (fixed) {
+            count += dispatch().fn16(cur.ptr<uint8_t>(r), bg.ptr<uint16_t>(r),
+                                     mask.ptr<uint8_t>(r), cols, threshold, alpha_q16);
+            continue;
+        }
+        count += dispatch().fn(cur.ptr<uint8_t>(r), bg.ptr<float>(r), mask.ptr<uint8_t>(r),
+                               cols, threshold, static_cast<float>(alpha));
+    }
+    return count;
+}
+
+const char* fusedKernelPath() {
+    return dispatch().name;
+}
+
+const char* fusedKernelMismatch(uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> byte(0, 255);
+    // Odd lengths exercise the scalar tails after the vector loops
+    for (int n : {1, 15, 17, 33, 4099}) {
+        std::vector<uint8_t> cur(n), mask(n), simd_mask(n);
+        std::vector<float> bg(n), simd_bg(n);
+        std::vector<uint16_t> bg16(n), simd_bg16(n);
+        for (int i = 0; i < n; ++i) {
+            cur[i] = static_cast<uint8_t>(byte(rng));
+            // Half-way values check that both round half to even
+            static const float kFractions[] = {0.0f, 0.5f, 0.25f, 0.75f, 0.4999f};
+            bg[i] = static_cast<float>(byte(rng)) + kFractions[i % 5];
+            // An 8.8 model never exceeds 255 << 8, which the SIMD rounding relies on
+            bg16[i] = static_cast<uint16_t>(std::min(255 << 8, byte(rng) << 8 | byte(rng)));
+        }
+        const int threshold = byte(rng) % 64;
+        const float alpha = 0.001f + (byte(rng) / 255.0f) * 0.5f;
+        const uint16_t alpha_q16 = static_cast<uint16_t>(alpha * 65536.0f);
+        for (const Dispatch& simd : simdKernels()) {
+            // Several frames, so updated backgrounds are compared too
+            std::vector<float> ref_bg = bg;
+            std::vector<uint16_t> ref_bg16 = bg16;
+            simd_bg = bg;
+            simd_bg16 = bg16;
+            for (int frame = 0; frame < 4; ++frame) {
+                int count = fusedScalar(cur.data(), ref_bg.data(), mask.data(), n, threshold, alpha);
+                int simd_count = simd.fn(cur.data(), simd_bg.data(), simd_mask.data(), n,
+                                         threshold, alpha);
+                if (count != simd_count || mask != simd_mask ||
+                    std::memcmp(ref_bg.data(), simd_bg.data(), n * sizeof(float)) != 0) {
+                    return simd.name;
+                }
+                count = fused16Scalar(cur.data(), ref_bg16.data(), mask.data(), n, threshold,
+                                      alpha_q16);
+                simd_count = simd.fn16(cur.data(), simd_bg16.data(), simd_mask.data(), n,
+                                       threshold, alpha_q16);
+                if (count != simd_count || mask != simd_mask || ref_bg16 != simd_bg16) {
+                    return simd.name;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
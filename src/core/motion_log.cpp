@@ -0,0 +1,301 @@
+#include "core/motion_log.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char kMotionCsvHeader[] =
+    "frame_id,timestamp_ms,motion_score,contour_count,"
+    "bbox_x,bbox_y,bbox_w,bbox_h,roi_x,roi_y,roi_w,roi_h,roi_index\n";
+
+namespace {
+
+struct ColumnSpec {
+    const char* name;
+    const char* dtype;
+    uint32_t elem_size;
+};
+
+// Order is also the CSV column order
+const ColumnSpec kColumns[] = {
+    {"frame_id", "<u8", 8},
+    {"timestamp_ms", "<i8", 8},
+    {"motion_score", "<f8", 8},
+    {"contour_count", "<i4", 4},
+    {"bbox_x", "<i4", 4},
+    {"bbox_y", "<i4", 4},
+    {"bbox_w", "<i4", 4},
+    {"bbox_h", "<i4", 4},
+    {"roi_x", "<i4", 4},
+    {"roi_y", "<i4", 4},
+    {"roi_w", "<i4", 4},
+    {"roi_h", "<i4", 4},
+    {"roi_index", "<i4", 4},
+};
+constexpr size_t kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+
+// Legacy exportCSV rows: 4 named columns followed by the unnamed ROI
+const char* const kLegacyColumns[] = {
+    "frame_id", "timestamp_ms", "motion_score", "contour_count",
+    "roi_x", "roi_y", "roi_w", "roi_h",
+};
+
+uint64_t alignUp(uint64_t v, uint64_t a) {
+    return (v + a - 1) / a * a;
+}
+
+void storeField(size_t col, const MotionEvent& e, char* dst) {
+    int32_t i32 = 0;
+    switch (col) {
+        case 0: std::memcpy(dst, &e.frame_id, 8); return;
+        case 1: std::memcpy(dst, &e.timestamp_ms, 8); return;
+        case 2: std::memcpy(dst, &e.motion_score, 8); return;
+        case 3: i32 = e.contour_count; break;
+        case 4: i32 = e.largest_bbox.x; break;
+        case 5: i32 = e.largest_bbox.y; break;
+        case 6: i32 = e.largest_bbox.width; break;
+        case 7: i32 = e.largest_bbox.height; break;
+        case 8: i32 = e.roi_used.x; break;
+        case 9: i32 = e.roi_used.y; break;
+        case 10: i32 = e.roi_used.width; break;
+        case 11: i32 = e.roi_used.height; break;
+        case 12: i32 = e.roi_index; break;
+    }
+    std::memcpy(dst, &i32, 4);
+}
+
+bool setField(const std::string& name, const std::string& value, MotionEvent& e) {
+    const char* v = value.c_str();
+    if (name == "frame_id") e.frame_id = std::strtoull(v, nullptr, 10);
+    else if (name == "timestamp_ms") e.timestamp_ms = std::strtoll(v, nullptr, 10);
+    else if (name == "motion_score") e.motion_score = std::strtod(v, nullptr);
+    else if (name == "contour_count") e.contour_count = std::atoi(v);
+    else if (name == "bbox_x") e.largest_bbox.x = std::atoi(v);
+    else if (name == "bbox_y") e.largest_bbox.y = std::atoi(v);
+    else if (name == "bbox_w") e.largest_bbox.width = std::atoi(v);
+    else if (name == "bbox_h") e.largest_bbox.height = std::atoi(v);
+    else if (name == "roi_x") e.roi_used.x = std::atoi(v);
+    else if (name == "roi_y") e.roi_used.y = std::atoi(v);
+    else if (name == "roi_w") e.roi_used.width = std::atoi(v);
+    else if (name == "roi_h") e.roi_used.height = std::atoi(v);
+    else if (name == "roi_index") e.roi_index = std::atoi(v);
+    else return false;
+    return true;
+}
+
+std::vector<std::string> splitCsv(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+        if (!field.empty() && field.back() == '\r') field.pop_back();
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+}  // namespace
+
+int formatMotionCsvRow(const MotionEvent& e, char* buf, size_t size) {
+    return std::snprintf(buf, size, "%llu,%lld,%g,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+        static_cast<unsigned long long>(e.frame_id),
+        static_cast<long long>(e.timestamp_ms),
+        e.motion_score, e.contour_count,
+        e.largest_bbox.x, e.largest_bbox.y, e.largest_bbox.width, e.largest_bbox.height,
+        e.roi_used.x, e.roi_used.y, e.roi_used.width, e.roi_used.height, e.roi_index);
+}
+
+std::vector<std::string> parseMotionCsvHeader(const std::string& line) {
+    return splitCsv(line);
+}
+
+bool parseMotionCsvRow(const std::string& line, const std::vector<std::string>& columns,
+                       MotionEvent& e) {
+    std::vector<std::string> fields = splitCsv(line);
+    if (fields.empty()) return false;
+    e = MotionEvent{};
+
+    bool legacy = columns.size() == 4 && fields.size() == 8;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (legacy) {
+            setField(kLegacyColumns[i], fields[i], e);
+        } else if (i < columns.size()) {
+            setField(columns[i], fields[i], e);
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+MotionLogWriter::~MotionLogWriter() {
+    close();
+}
+
+size_t MotionLogWriter::rowBytes() {
+    size_t bytes = 0;
+    for (const auto& spec : kColumns) bytes += spec.elem_size;
+    return bytes;
+}
+
+bool MotionLogWriter::open(const std::string& path, uint64_t capacity) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) return false;
+
+    capacity_ = std::max<uint64_t>(capacity, 1);
+    count_ = 0;
+    columns_.assign(kColumnCount, MotionLogColumn{});
+
+    uint32_t header_size = sizeof(MotionLogHeader) + kColumnCount * sizeof(MotionLogColumn);
+    uint64_t offset = alignUp(header_size, 64);
+    for (size_t i = 0; i < kColumnCount; ++i) {
+        MotionLogColumn& col = columns_[i];
+        std::strncpy(col.name, kColumns[i].name, sizeof(col.name));
+        std::memcpy(col.dtype, kColumns[i].dtype, 3);
+        col.elem_size = kColumns[i].elem_size;
+        col.offset = offset;
+        offset = alignUp(offset + capacity_ * col.elem_size, 64);
+    }
+
+    MotionLogHeader header{};
+    std::memcpy(header.magic, kMotionLogMagic, sizeof(header.magic));
+    header.version = kMotionLogVersion;
+    header.column_count = kColumnCount;
+    header.capacity = capacity_;
+    header.count = 0;
+    header.header_size = header_size;
+
+    // Reserve the full size up front; unwritten rows stay sparse
+    if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0 ||
+        ::pwrite(fd_, &header, sizeof(header), 0) != sizeof(header) ||
+        ::pwrite(fd_, columns_.data(), kColumnCount * sizeof(MotionLogColumn),
+                 sizeof(header)) != static_cast<ssize_t>(kColumnCount * sizeof(MotionLogColumn))) {
+        close();
+        return false;
+    }
+    pending_.reserve(1024);
+    return true;
+}
+
+bool MotionLogWriter::append(const MotionEvent& e) {
+    if (fd_ < 0 || full()) return false;
+    pending_.push_back(e);
+    return true;
+}
+
+bool MotionLogWriter::flush() {
+    if (fd_ < 0 || pending_.empty()) return fd_ >= 0;
+
+    for (size_t c = 0; c < kColumnCount; ++c) {
+        const MotionLogColumn& col = columns_[c];
+        size_t bytes = pending_.size() * col.elem_size;
+        scratch_.resize(bytes);
+        for (size_t r = 0; r < pending_.size(); ++r) {
+            storeField(c, pending_[r], scratch_.data() + r * col.elem_size);
+        }
+        off_t at = static_cast<off_t>(col.offset + count_ * col.elem_size);
+        if (::pwrite(fd_, scratch_.data(), bytes, at) != static_cast<ssize_t>(bytes)) {
+            return false;
+        }
+    }
+
+    // Publish the rows only after their column data is in place
+    count_ += pending_.size();
+    pending_.clear();
+    return ::pwrite(fd_, &count_, sizeof(count_), offsetof(MotionLogHeader, count))
+        == sizeof(count_);
+}
+
+void MotionLogWriter::close() {
+    if (fd_ < 0) return;
+    flush();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+// ---------------------------------------------------------------------------
+
+MotionLogReader::~MotionLogReader() {
+    close();
+}
+
+bool MotionLogReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MotionLogHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    base_ = static_cast<const char*>(mapped);
+    size_ = st.st_size;
+    header_ = reinterpret_cast<const MotionLogHeader*>(base_);
+    columns_ = reinterpret_cast<const MotionLogColumn*>(base_ + sizeof(MotionLogHeader));
+
+    bool valid = std::memcmp(header_->magic, kMotionLogMagic, sizeof(kMotionLogMagic)) == 0 &&
+                 header_->version <= kMotionLogVersion &&
+                 header_->header_size <= size_ &&
+                 sizeof(MotionLogHeader) + header_->column_count * sizeof(MotionLogColumn)
+                     <= header_->header_size;
+    for (uint32_t i = 0; valid && i < header_->column_count; ++i) {
+        valid = columns_[i].offset + header_->capacity * columns_[i].elem_size <= size_;
+    }
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MotionLogReader::close() {
+    if (base_) ::munmap(const_cast<char*>(base_), size_);
+    base_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    columns_ = nullptr;
+}
+
+uint64_t MotionLogReader::count() const {
+    if (!header_) return 0;
+    uint64_t n = __atomic_load_n(&header_->count, __ATOMIC_ACQUIRE);
+    return std::min(n, header_->capacity);
+}
+
+const MotionLogColumn* MotionLogReader::findColumn(const char* name) const {
+    if (!header_) return nullptr;
+    for (uint32_t i = 0; i < header_->column_count; ++i) {
+        if (std::strncmp(columns_[i].name, name, sizeof(columns_[i].name)) == 0) {
+            return &columns_[i];
+        }
+    }
+    return nullptr;
+}
+
+MotionEvent MotionLogReader::event(uint64_t row) const {
+    auto get = [&](const char* name) -> int32_t {
+        const int32_t* col = column<int32_t>(name);
+        return col ? col[row] : 0;
+    };
+    MotionEvent e{};
+    if (const uint64_t* ids = column<uint64_t>("frame_id")) e.frame_id = ids[row];
+    if (const int64_t* ts = column<int64_t>("timestamp_ms")) e.timestamp_ms = ts[row];
+    if (const double* score = column<double>("motion_score")) e.motion_score = score[row];
+    e.contour_count = get("contour_count");
+    e.largest_bbox = cv::Rect(get("bbox_x"), get("bbox_y"), get("bbox_w"), get("bbox_h"));
+    e.roi_used = cv::Rect(get("roi_x"), get("roi_y"), get("roi_w"), get("roi_h"));
+    e.roi_index = get("roi_index");
+    return e;
+}
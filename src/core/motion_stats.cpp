@@ -0,0 +1,239 @@
+#include "core/motion_stats.hpp"
+#include <algorithm>
+#include <cmath>
+
+RunningStats::RunningStats(double window)
+    : alpha_(window > 0 ? 2.0 / (window + 1.0) : 0.0) {}
+
+/**
+ * Welford in its weighted form (West, 1979): with weight a = 1/n this is
+ * the textbook cumulative update, with a fixed a an exponentially
+ * weighted one. Taking the larger of the two warms the window up.
+ */
+void RunningStats::add(double x) {
+    ++count_;
+    double a = std::max(alpha_, 1.0 / static_cast<double>(count_));
+    double diff = x - mean_;
+    double step = a * diff;
+    mean_ += step;
+    variance_ = (1.0 - a) * (variance_ + diff * step);
+}
+
+double RunningStats::stddev() const {
+    return std::sqrt(std::max(0.0, variance_));
+}
+
+// ---------------------------------------------------------------------------
+
+P2Quantile::P2Quantile(double q) : q_(std::min(1.0, std::max(0.0, q))) {
+    desired_[0] = 1;
+    desired_[1] = 1 + 2 * q_;
+    desired_[2] = 1 + 4 * q_;
+    desired_[3] = 3 + 2 * q_;
+    desired_[4] = 5;
+    increment_[0] = 0;
+    increment_[1] = q_ / 2;
+    increment_[2] = q_;
+    increment_[3] = (1 + q_) / 2;
+    increment_[4] = 1;
+}
+
+void P2Quantile::add(double x) {
+    if (count_ < 5) {
+        height_[count_++] = x;
+        if (count_ == 5) std::sort(height_, height_ + 5);
+        return;
+    }
+    ++count_;
+
+    int k;
+    if (x < height_[0]) {
+        height_[0] = x;
+        k = 0;
+    } else if (x >= height_[4]) {
+        height_[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (k < 3 && x >= height_[k + 1]) ++k;
+    }
+    for (int i = k + 1; i < 5; ++i) position_[i] += 1;
+    for (int i = 0; i < 5; ++i) desired_[i] += increment_[i];
+
+    // Move the middle markers toward their desired positions
+    for (int i = 1; i < 4; ++i) {
+        double d = desired_[i] - position_[i];
+        if ((d >= 1 && position_[i + 1] - position_[i] > 1) ||
+            (d <= -1 && position_[i - 1] - position_[i] < -1)) {
+            int step = d > 0 ? 1 : -1;
+            double h = parabolic(i, step);
+            if (!(height_[i - 1] < h && h < height_[i + 1])) h = linear(i, step);
+            height_[i] = h;
+            position_[i] += step;
+        }
+    }
+}
+
+double P2Quantile::parabolic(int i, int d) const {
+    const double* n = position_;
+    const double* h = height_;
+    return h[i] + d / (n[i + 1] - n[i - 1]) *
+        ((n[i] - n[i - 1] + d) * (h[i + 1] - h[i]) / (n[i + 1] - n[i]) +
+         (n[i + 1] - n[i] - d) * (h[i] - h[i - 1]) / (n[i] - n[i - 1]));
+}
+
+double P2Quantile::linear(int i, int d) const {
+    return height_[i] + d * (height_[i + d] - height_[i]) / (position_[i + d] - position_[i]);
+}
+
+double P2Quantile::value() const {
+    if (count_ == 0) return 0.0;
+    if (count_ < 5) {
+        double sorted[5];
+        std::copy(height_, height_ + count_, sorted);
+        std::sort(sorted, sorted + count_);
+        return sorted[static_cast<size_t>(std::lround(q_ * (count_ - 1)))];
+    }
+    return height_[2];
+}
+
+// ---------------------------------------------------------------------------
+
+EpisodeDetector::EpisodeDetector() : EpisodeDetector(Options{}) {}
+
+EpisodeDetector::EpisodeDetector(const Options& opts)
+    : opts_(opts), baseline_(opts.baseline_window) {}
+
+double EpisodeDetector::startThreshold() const {
+    if (opts_.threshold > 0) return opts_.threshold;
+    return std::max(opts_.min_score, baseline_.mean() + opts_.sigma * baseline_.stddev());
+}
+
+bool EpisodeDetector::add(const MotionEvent& event, MotionEpisode& out) {
+    const double score = event.motion_score;
+    if (!active_) {
+        double start = startThreshold();
+        if (score < start) {
+            baseline_.add(score);
+            return false;
+        }
+        active_ = true;
+        // Hysteresis between the quiet mean and the start threshold
+        double quiet = opts_.threshold > 0 ? 0.0 : baseline_.mean();
+        release_threshold_ = quiet + (start - quiet) * opts_.release;
+        score_sum_ = pending_sum_ = 0.0;
+        pending_frames_ = 0;
+        current_ = MotionEpisode();
+        current_.roi_index = event.roi_index;
+        current_.start_frame = current_.end_frame = current_.peak_frame = event.frame_id;
+        current_.start_ms = current_.end_ms = current_.peak_ms = event.timestamp_ms;
+    }
+
+    ++pending_frames_;
+    pending_sum_ += score;
+    if (score >= release_threshold_) {
+        // Quiet frames inside the episode count once activity resumes
+        current_.frames += pending_frames_;
+        score_sum_ += pending_sum_;
+        pending_frames_ = 0;
+        pending_sum_ = 0.0;
+        current_.end_frame = event.frame_id;
+        current_.end_ms = event.timestamp_ms;
+        if (score > current_.peak_score) {
+            current_.peak_score = score;
+            current_.peak_frame = event.frame_id;
+            current_.peak_ms = event.timestamp_ms;
+        }
+        return false;
+    }
+    if (event.timestamp_ms - current_.end_ms < opts_.gap_ms) return false;
+    return close(out);
+}
+
+bool EpisodeDetector::finish(MotionEpisode& out) {
+    return active_ && close(out);
+}
+
+bool EpisodeDetector::close(MotionEpisode& out) {
+    active_ = false;
+    if (current_.durationMs() < opts_.min_duration_ms) return false;
+    out = current_;
+    out.mean_score = current_.frames ? score_sum_ / current_.frames : 0.0;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+namespace {
+constexpr double kRecentWindow = 900;  // frames; 30 s at 30 fps
+}
+
+MotionStats::RoiStats::RoiStats(const EpisodeDetector::Options& opts)
+    : recent(kRecentWindow), episode(opts) {}
+
+MotionStats::MotionStats() : MotionStats(EpisodeDetector::Options{}) {}
+
+MotionStats::MotionStats(const EpisodeDetector::Options& episode_opts)
+    : episode_opts_(episode_opts) {}
+
+MotionStats::RoiStats& MotionStats::roi(int index) {
+    size_t i = static_cast<size_t>(std::max(0, index));
+    while (rois_.size() <= i) rois_.emplace_back(episode_opts_);
+    return rois_[i];
+}
+
+void MotionStats::add(const MotionEvent& event, std::vector<MotionEpisode>& finished) {
+    RoiStats& s = roi(event.roi_index);
+    const double score = event.motion_score;
+    s.all.add(score);
+    s.recent.add(score);
+    s.p50.add(score);
+    s.p95.add(score);
+    s.p99.add(score);
+    s.max = std::max(s.max, score);
+
+    MotionEpisode episode;
+    if (s.episode.add(event, episode)) {
+        ++s.episodes;
+        finished.push_back(episode);
+    }
+}
+
+void MotionStats::finish(std::vector<MotionEpisode>& finished) {
+    for (RoiStats& s : rois_) {
+        MotionEpisode episode;
+        if (s.episode.finish(episode)) {
+            ++s.episodes;
+            finished.push_back(episode);
+        }
+    }
+}
+
+bool MotionStats::inEpisode() const {
+    for (const RoiStats& s : rois_) {
+        if (s.episode.active()) return true;
+    }
+    return false;
+}
+
+std::vector<MotionStats::RoiSummary> MotionStats::summary() const {
+    std::vector<RoiSummary> out;
+    for (size_t i = 0; i < rois_.size(); ++i) {
+        const RoiStats& s = rois_[i];
+        RoiSummary r;
+        r.roi_index = static_cast<int>(i);
+        r.frames = s.all.count();
+        r.mean = s.all.mean();
+        r.stddev = s.all.stddev();
+        r.recent_mean = s.recent.mean();
+        r.recent_stddev = s.recent.stddev();
+        r.p50 = s.p50.value();
+        r.p95 = s.p95.value();
+        r.p99 = s.p99.value();
+        r.max = s.max;
+        r.episodes = s.episodes;
+        r.in_episode = s.episode.active();
+        out.push_back(r);
+    }
+    return out;
+}
@@ -0,0 +1,36 @@
+#include "core/overlay.hpp"
+#include <cstdio>
+
+bool renderOverlay(const DetectionResult& result, cv::Mat& out,
+                   const std::vector<std::string>& roi_names, bool draw_roi) {
+    if (result.frame.empty()) return false;
+    result.frame.copyTo(out);
+
+    for (const auto& box : result.boxes) {
+        cv::rectangle(out, box, cv::Scalar(0, 255, 0), 2);
+    }
+
+    double motion = 0.0;
+    int objects = 0;
+    for (const auto& event : result.events) {
+        if (draw_roi) {
+            const cv::Rect& roi = event.roi_used;
+            size_t index = static_cast<size_t>(event.roi_index);
+            std::string label = index < roi_names.size() && !roi_names[index].empty()
+                ? roi_names[index] : "ROI";
+            cv::rectangle(out, roi, cv::Scalar(255, 0, 0), 2);
+            cv::putText(out, label, cv::Point(roi.x + 5, roi.y + 20),
+                cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 0, 0), 1);
+        }
+        motion += event.motion_score;
+        objects += event.contour_count;
+    }
+
+    unsigned long long frame_id = result.events.empty() ? 0 : result.events.front().frame_id;
+    char stats[128];
+    snprintf(stats, sizeof(stats), "Motion: %.2f%% | Objects: %d | Frame: %llu",
+        motion, objects, frame_id);
+    cv::putText(out, stats, cv::Point(10, 30),
+        cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
+    return true;
+}
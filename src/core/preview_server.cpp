@@ -0,0 +1,350 @@
+#include "core/preview_server.hpp"
+#include "core/overlay.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kMaxRequestBytes = 4096;
+constexpr int64_t kRequestTimeoutMs = 5000;
+constexpr int kIdlePollMs = 200;  // how soon stop() is noticed with no viewers
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool setNonBlocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+std::shared_ptr<const std::string> reply(const std::string& status, const std::string& type,
+                                         const std::string& body) {
+    return std::make_shared<const std::string>(
+        "HTTP/1.0 " + status + "\r\nContent-Type: " + type + "\r\nContent-Length: " +
+        std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+}
+
+}  // namespace
+
+PreviewServer::PreviewServer(const Options& opts)
+    : opts_(opts)
+    , stream_header_(std::make_shared<const std::string>(
+          "HTTP/1.0 200 OK\r\n"
+          "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n"
+          "Cache-Control: no-cache\r\n"
+          "Connection: close\r\n\r\n")) {
+    opts_.fps = opts_.fps > 0 ? opts_.fps : 5.0;
+    opts_.max_clients = std::max<size_t>(1, opts_.max_clients);
+}
+
+PreviewServer::~PreviewServer() {
+    stop();
+}
+
+size_t PreviewServer::addStream(BroadcastChannel<DetectionResult>& results, RateCallback set_rate) {
+    Feed feed;
+    feed.results = &results;
+    feed.set_rate = std::move(set_rate);
+    feeds_.push_back(std::move(feed));
+    return feeds_.size() - 1;
+}
+
+bool PreviewServer::start() {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(opts_.port));
+    if (::inet_pton(AF_INET, opts_.bind_address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "PreviewServer: bad bind address " << opts_.bind_address << std::endl;
+        return false;
+    }
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    if (listen_fd_ < 0 ||
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd_, 16) != 0 || !setNonBlocking(listen_fd_)) {
+        std::cerr << "PreviewServer: cannot listen on " << opts_.bind_address << ":"
+                  << opts_.port << ": " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    if (::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        bound_port_ = ntohs(addr.sin_port);
+    }
+    running_ = true;
+    thread_ = std::thread(&PreviewServer::run, this);
+    return true;
+}
+
+void PreviewServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    for (auto& client : clients_) closeClient(client);
+    clients_.clear();
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void PreviewServer::run() {
+    const int64_t interval_ms = std::max<int64_t>(1, static_cast<int64_t>(1000.0 / opts_.fps));
+    int64_t next_tick = nowMs();
+    std::vector<pollfd> fds;
+
+    while (running_) {
+        bool watching = false;
+        fds.clear();
+        fds.push_back(pollfd{listen_fd_, POLLIN, 0});
+        for (const auto& client : clients_) {
+            // Streaming clients are polled for input too, to notice hang-ups
+            short events = POLLIN;
+            if (client.current) events |= POLLOUT;
+            fds.push_back(pollfd{client.fd, events, 0});
+            watching = watching || client.feed >= 0;
+        }
+        int64_t now = nowMs();
+        int timeout = watching ? static_cast<int>(std::clamp<int64_t>(next_tick - now, 0, kIdlePollMs))
+                               : kIdlePollMs;
+        if (::poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) break;
+
+        // fds[i + 1] belongs to clients_[i]; accepted clients are appended
+        const size_t polled = fds.size() - 1;
+        for (size_t i = 0; i < polled; ++i) {
+            Client& client = clients_[i];
+            const short revents = fds[i + 1].revents;
+            if (revents & (POLLERR | POLLNVAL)) {
+                closeClient(client);
+            } else if (revents & (POLLIN | POLLHUP)) {
+                readRequest(client);
+            }
+            if (!client.closed && (revents & POLLOUT)) writeClient(client);
+        }
+        if (fds[0].revents & POLLIN) acceptClients();
+
+        now = nowMs();
+        for (auto& client : clients_) {
+            if (!client.closed && client.feed < 0 && !client.current &&
+                now - client.accepted_ms > kRequestTimeoutMs) {
+                closeClient(client);
+            }
+        }
+        clients_.erase(std::remove_if(clients_.begin(), clients_.end(),
+                                      [](const Client& c) { return c.closed; }),
+                       clients_.end());
+
+        if (now >= next_tick) {
+            encodeFrames();
+            // Skip missed ticks rather than encoding a burst to catch up
+            next_tick = std::max(next_tick + interval_ms, now);
+        }
+    }
+}
+
+void PreviewServer::acceptClients() {
+    while (true) {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) return;
+        if (clients_.size() >= opts_.max_clients || !setNonBlocking(fd)) {
+            static const char kBusy[] = "HTTP/1.0 503 Service Unavailable\r\nConnection: close\r\n\r\n";
+            ssize_t ignored = ::send(fd, kBusy, sizeof(kBusy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+            (void)ignored;
+            ::close(fd);
+            continue;
+        }
+        int nodelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        Client client;
+        client.fd = fd;
+        client.accepted_ms = nowMs();
+        clients_.push_back(std::move(client));
+        connections_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void PreviewServer::readRequest(Client& client) {
+    char buffer[1024];
+    ssize_t n = ::recv(client.fd, buffer, sizeof(buffer), 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        closeClient(client);  // hung up
+        return;
+    }
+    if (n < 0 || client.feed >= 0 || client.close_after) return;  // nothing more is expected
+
+    client.request.append(buffer, static_cast<size_t>(n));
+    if (client.request.find("\r\n\r\n") == std::string::npos &&
+        client.request.find("\n\n") == std::string::npos) {
+        if (client.request.size() > kMaxRequestBytes) closeClient(client);
+        return;
+    }
+    // Request line: METHOD SP PATH SP VERSION
+    size_t method_end = client.request.find(' ');
+    size_t path_end = method_end == std::string::npos
+        ? std::string::npos : client.request.find(' ', method_end + 1);
+    if (path_end == std::string::npos || client.request.compare(0, method_end, "GET") != 0) {
+        client.current = reply("405 Method Not Allowed", "text/plain", "GET only\n");
+        client.close_after = true;
+    } else {
+        route(client, client.request.substr(method_end + 1, path_end - method_end - 1));
+    }
+    client.request.clear();
+    client.request.shrink_to_fit();
+}
+
+void PreviewServer::route(Client& client, const std::string& path) {
+    if (path == "/") {
+        std::string body = "<html><head><title>Motion Detector</title></head><body>\n";
+        for (size_t i = 0; i < feeds_.size(); ++i) {
+            std::string url = "/stream/" + std::to_string(i);
+            body += "<p>Stream " + std::to_string(i) + "<br><img src=\"" + url + "\"></p>\n";
+        }
+        body += "</body></html>\n";
+        client.current = reply("200 OK", "text/html", body);
+        client.close_after = true;
+        return;
+    }
+    const std::string prefix = "/stream/";
+    if (path.compare(0, prefix.size(), prefix) == 0) {
+        const std::string index = path.substr(prefix.size());
+        if (!index.empty() && index.size() < 6 &&
+            std::all_of(index.begin(), index.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            size_t feed = std::stoul(index);
+            if (feed < feeds_.size()) {
+                addViewer(client, static_cast<int>(feed));
+                return;
+            }
+        }
+    }
+    client.current = reply("404 Not Found", "text/plain", "Unknown stream\n");
+    client.close_after = true;
+}
+
+void PreviewServer::addViewer(Client& client, int feed) {
+    client.feed = feed;
+    client.current = stream_header_;
+    client.offset = 0;
+    Feed& f = feeds_[feed];
+    if (f.viewers++ == 0) {
+        // ALL rather than LATEST: the newest result may carry no frame
+        f.subscriber = f.results->subscribe(BroadcastChannel<DetectionResult>::Policy::ALL,
+                                            f.results->capacity());
+        if (f.set_rate) f.set_rate(opts_.fps);
+    }
+}
+
+void PreviewServer::closeClient(Client& client) {
+    if (client.closed) return;
+    client.closed = true;
+    ::close(client.fd);
+    client.current.reset();
+    client.next.reset();
+    if (client.feed < 0) return;
+    Feed& f = feeds_[client.feed];
+    if (--f.viewers == 0) {
+        if (f.set_rate) f.set_rate(0.0);
+        f.subscriber.reset();
+    }
+}
+
+void PreviewServer::writeClient(Client& client) {
+    while (client.current) {
+        const std::string& data = *client.current;
+        ssize_t n = ::send(client.fd, data.data() + client.offset, data.size() - client.offset,
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) closeClient(client);
+            return;  // socket buffer full: resume on the next POLLOUT
+        }
+        client.offset += static_cast<size_t>(n);
+        if (client.offset < data.size()) continue;
+
+        if (client.feed >= 0 && client.current != stream_header_) {
+            frames_sent_.fetch_add(1, std::memory_order_relaxed);
+        }
+        client.current = std::move(client.next);
+        client.next.reset();
+        client.offset = 0;
+        if (!client.current && client.close_after) {
+            closeClient(client);
+            return;
+        }
+    }
+}
+
+/**
+ * Encodes the newest framed result of each watched stream once and queues
+ * the same buffer on every client of that stream.
+ */
+void PreviewServer::encodeFrames() {
+    for (size_t f = 0; f < feeds_.size(); ++f) {
+        Feed& feed = feeds_[f];
+        if (feed.viewers == 0) continue;
+        BroadcastChannel<DetectionResult>::Ptr newest;
+        while (auto result = feed.subscriber->tryNext()) {
+            if (!result->frame.empty()) newest = std::move(result);
+        }
+        Chunk frame;
+        if (!newest || !encode(*newest, frame)) continue;
+
+        for (auto& client : clients_) {
+            if (client.closed || client.feed != static_cast<int>(f)) continue;
+            if (!client.current) {
+                client.current = frame;
+                client.offset = 0;
+            } else {
+                if (client.next) frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+                client.next = frame;
+            }
+        }
+    }
+}
+
+bool PreviewServer::encode(const DetectionResult& result, Chunk& out) {
+    auto t0 = std::chrono::steady_clock::now();
+    if (!renderOverlay(result, overlay_, opts_.roi_names)) return false;
+    const cv::Mat* image = &overlay_;
+    if (opts_.max_width > 0 && overlay_.cols > opts_.max_width) {
+        double scale = static_cast<double>(opts_.max_width) / overlay_.cols;
+        cv::resize(overlay_, scaled_, cv::Size(), scale, scale, cv::INTER_AREA);
+        image = &scaled_;
+    }
+    if (!cv::imencode(".jpg", *image, jpeg_, {cv::IMWRITE_JPEG_QUALITY, opts_.jpeg_quality})) {
+        return false;
+    }
+    std::string part = "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: " +
+                       std::to_string(jpeg_.size()) + "\r\n\r\n";
+    auto chunk = std::make_shared<std::string>();
+    chunk->reserve(part.size() + jpeg_.size() + 2);
+    chunk->append(part);
+    chunk->append(reinterpret_cast<const char*>(jpeg_.data()), jpeg_.size());
+    chunk->append("\r\n");
+    out = std::move(chunk);
+
+    frames_encoded_.fetch_add(1, std::memory_order_relaxed);
+    encode_us_.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0).count(), std::memory_order_relaxed);
+    return true;
+}
+
+PreviewServer::Stats PreviewServer::stats() const {
+    Stats s;
+    s.connections = connections_.load(std::memory_order_relaxed);
+    s.frames_encoded = frames_encoded_.load(std::memory_order_relaxed);
+    s.frames_sent = frames_sent_.load(std::memory_order_relaxed);
+    s.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+    s.encode_ms = encode_us_.load(std::memory_order_relaxed) / 1000.0;
+    return s;
+}
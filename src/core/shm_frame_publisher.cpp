@@ -0,0 +1,147 @@
+#include "core/shm_frame_publisher.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ShmFramePublisher::ShmFramePublisher(const Options& opts) : opts_(opts) {
+    opts_.slots = std::max<uint32_t>(2, opts_.slots);
+}
+
+ShmFramePublisher::~ShmFramePublisher() {
+    close();
+}
+
+bool ShmFramePublisher::create(size_t frame_bytes, size_t mask_bytes) {
+    const uint64_t slot_headers = shmAlign(sizeof(ShmRingHeader) +
+                                           opts_.slots * sizeof(ShmSlotHeader));
+    const uint64_t frame_stride = shmAlign(frame_bytes);
+    const uint64_t slot_data = frame_stride + shmAlign(mask_bytes);
+    const uint64_t total = slot_headers + opts_.slots * slot_data;
+
+    ::shm_unlink(opts_.name.c_str());  // stale ring from an earlier run
+    int fd = ::shm_open(opts_.name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        std::cerr << "ShmFramePublisher: cannot create " << opts_.name << ": "
+                  << std::strerror(errno) << std::endl;
+        return false;
+    }
+    void* mapped = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(total)) == 0) {
+        mapped = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "ShmFramePublisher: cannot map " << total << " bytes for "
+                  << opts_.name << std::endl;
+        ::shm_unlink(opts_.name.c_str());
+        return false;
+    }
+
+    base_ = static_cast<char*>(mapped);
+    size_ = total;
+    header_ = new (base_) ShmRingHeader();
+    header_->version = kShmRingVersion;
+    header_->slot_count = opts_.slots;
+    header_->total_size = total;
+    header_->frame_capacity = frame_bytes;
+    header_->mask_capacity = mask_bytes;
+    header_->published.store(0, std::memory_order_relaxed);
+    header_->state.store(SHM_RING_LIVE, std::memory_order_relaxed);
+
+    slots_ = reinterpret_cast<ShmSlotHeader*>(base_ + sizeof(ShmRingHeader));
+    for (uint32_t i = 0; i < opts_.slots; ++i) {
+        ShmSlotHeader* slot = new (&slots_[i]) ShmSlotHeader();
+        slot->seq.store(0, std::memory_order_relaxed);
+        slot->frame_offset = slot_headers + i * slot_data;
+        slot->mask_offset = slot->frame_offset + frame_stride;
+    }
+    // Readers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, kShmRingMagic, sizeof(kShmRingMagic));
+    return true;
+}
+
+bool ShmFramePublisher::publish(const TimestampedFrame& tf, const MotionDetector& detector) {
+    const cv::Mat& frame = tf.frame;
+    const size_t frame_bytes = frame.total() * frame.elemSize();
+    const cv::Size mask_size = detector.maskSize();
+    const size_t mask_bytes = static_cast<size_t>(mask_size.area());
+    if (!header_ && !failed_) {
+        // The mask never exceeds the frame: it covers part of it at <= 1x
+        failed_ = !create(frame_bytes, static_cast<size_t>(frame.cols) * frame.rows);
+    }
+    if (!header_ || frame_bytes > header_->frame_capacity ||
+        mask_bytes > header_->mask_capacity) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint64_t n = header_->published.load(std::memory_order_relaxed);
+    ShmSlotHeader& slot = slots_[n % opts_.slots];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.frame_id = tf.frame_id;
+    slot.timestamp_ms = tf.timestamp_ms;
+    slot.width = frame.cols;
+    slot.height = frame.rows;
+    slot.type = frame.type();
+    slot.step = static_cast<int32_t>(frame.cols * frame.elemSize());
+    cv::Mat pixels(frame.rows, frame.cols, frame.type(), base_ + slot.frame_offset);
+    frame.copyTo(pixels);
+
+    const cv::Rect& rect = detector.maskRect();
+    slot.mask_width = mask_size.width;
+    slot.mask_height = mask_size.height;
+    slot.mask_rect[0] = rect.x;
+    slot.mask_rect[1] = rect.y;
+    slot.mask_rect[2] = rect.width;
+    slot.mask_rect[3] = rect.height;
+    cv::Mat mask(mask_size, CV_8UC1, base_ + slot.mask_offset);
+    detector.motionMask(mask);
+
+    const std::vector<MotionEvent>& events = detector.events();
+    slot.event_count = static_cast<uint32_t>(std::min<size_t>(events.size(), kShmMaxEvents));
+    for (uint32_t i = 0; i < slot.event_count; ++i) {
+        const MotionEvent& e = events[i];
+        ShmMotionEvent& out = slot.events[i];
+        out.frame_id = e.frame_id;
+        out.timestamp_ms = e.timestamp_ms;
+        out.motion_score = e.motion_score;
+        out.contour_count = e.contour_count;
+        out.roi_index = e.roi_index;
+        const int32_t box[4] = {e.largest_bbox.x, e.largest_bbox.y,
+                                e.largest_bbox.width, e.largest_bbox.height};
+        const int32_t roi[4] = {e.roi_used.x, e.roi_used.y, e.roi_used.width, e.roi_used.height};
+        std::memcpy(out.largest_bbox, box, sizeof(box));
+        std::memcpy(out.roi, roi, sizeof(roi));
+    }
+
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    header_->published.store(n + 1, std::memory_order_release);
+    published_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ShmFramePublisher::close() {
+    if (!base_) return;
+    header_->state.store(SHM_RING_CLOSED, std::memory_order_release);
+    ::munmap(base_, size_);
+    // Attached readers keep their mapping until they close it
+    ::shm_unlink(opts_.name.c_str());
+    base_ = nullptr;
+    header_ = nullptr;
+    slots_ = nullptr;
+}
+
+ShmFramePublisher::Stats ShmFramePublisher::stats() const {
+    Stats s;
+    s.published = published_.load(std::memory_order_relaxed);
+    s.skipped = skipped_.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,155 @@
+#include "core/shm_frame_reader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ShmFrameReader::~ShmFrameReader() {
+    close();
+}
+
+bool ShmFrameReader::open(const std::string& name) {
+    close();
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    base_ = static_cast<char*>(mapped);
+    size_ = static_cast<size_t>(st.st_size);
+
+    // The publisher writes the magic last
+    const ShmRingHeader* header = reinterpret_cast<const ShmRingHeader*>(base_);
+    bool ok = std::memcmp(header->magic, kShmRingMagic, sizeof(kShmRingMagic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    ok = ok && header->version == kShmRingVersion && header->total_size == size_ &&
+         header->slot_count > 0 &&
+         sizeof(ShmRingHeader) + header->slot_count * sizeof(ShmSlotHeader) <= size_;
+    const ShmSlotHeader* slots = reinterpret_cast<const ShmSlotHeader*>(base_ + sizeof(ShmRingHeader));
+    for (uint32_t i = 0; ok && i < header->slot_count; ++i) {
+        ok = slots[i].frame_offset + header->frame_capacity <= size_ &&
+             slots[i].mask_offset + header->mask_capacity <= size_;
+    }
+    if (!ok) {
+        close();
+        return false;
+    }
+    header_ = header;
+    slots_ = slots;
+    cursor_ = 0;
+    started_ = false;
+    skipped_ = 0;
+    return true;
+}
+
+void ShmFrameReader::close() {
+    if (base_) ::munmap(base_, size_);
+    base_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    slots_ = nullptr;
+}
+
+uint64_t ShmFrameReader::published() const {
+    return header_ ? header_->published.load(std::memory_order_acquire) : 0;
+}
+
+bool ShmFrameReader::closed() const {
+    return !header_ || header_->state.load(std::memory_order_acquire) == SHM_RING_CLOSED;
+}
+
+/**
+ * Seqlock read of frame `index`: copies the slot's metadata, confirms the
+ * sequence didn't move, then builds views from the copy so a torn header
+ * can't produce a bad Mat.
+ */
+bool ShmFrameReader::read(uint64_t index, ShmFrame& out) const {
+    const ShmSlotHeader& slot = slots_[index % header_->slot_count];
+    const uint64_t expected = 2 * index + 2;
+    if (slot.seq.load(std::memory_order_acquire) != expected) return false;
+
+    const int32_t width = slot.width, height = slot.height, type = slot.type, step = slot.step;
+    const int32_t mask_width = slot.mask_width, mask_height = slot.mask_height;
+    int32_t mask_rect[4];
+    std::memcpy(mask_rect, slot.mask_rect, sizeof(mask_rect));
+    const uint64_t frame_id = slot.frame_id;
+    const int64_t timestamp_ms = slot.timestamp_ms;
+    const uint32_t event_count = std::min(slot.event_count, kShmMaxEvents);
+    ShmMotionEvent events[kShmMaxEvents];
+    std::memcpy(events, slot.events, event_count * sizeof(ShmMotionEvent));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != expected) return false;
+
+    if (width <= 0 || height <= 0 || step <= 0 || mask_width < 0 || mask_height < 0 ||
+        static_cast<uint64_t>(step) * height > header_->frame_capacity ||
+        static_cast<uint64_t>(mask_width) * mask_height > header_->mask_capacity) {
+        return false;
+    }
+    out.index = index;
+    out.frame_id = frame_id;
+    out.timestamp_ms = timestamp_ms;
+    out.frame = cv::Mat(height, width, type, base_ + slot.frame_offset, static_cast<size_t>(step));
+    if (out.frame.cols * out.frame.elemSize() > static_cast<size_t>(step)) return false;
+    out.mask = cv::Mat(mask_height, mask_width, CV_8UC1, base_ + slot.mask_offset);
+    out.mask_rect = cv::Rect(mask_rect[0], mask_rect[1], mask_rect[2], mask_rect[3]);
+    out.events.clear();
+    for (uint32_t i = 0; i < event_count; ++i) {
+        const ShmMotionEvent& e = events[i];
+        MotionEvent event;
+        event.frame_id = e.frame_id;
+        event.timestamp_ms = e.timestamp_ms;
+        event.motion_score = e.motion_score;
+        event.contour_count = e.contour_count;
+        event.roi_index = e.roi_index;
+        event.largest_bbox = cv::Rect(e.largest_bbox[0], e.largest_bbox[1],
+                                      e.largest_bbox[2], e.largest_bbox[3]);
+        event.roi_used = cv::Rect(e.roi[0], e.roi[1], e.roi[2], e.roi[3]);
+        out.events.push_back(event);
+    }
+    return true;
+}
+
+bool ShmFrameReader::latest(ShmFrame& out) {
+    const uint64_t published = this->published();
+    if (published == 0) return false;
+    started_ = true;
+    if (!read(published - 1, out)) return false;
+    cursor_ = published;
+    return true;
+}
+
+bool ShmFrameReader::next(ShmFrame& out) {
+    const uint64_t published = this->published();
+    if (!started_) {
+        if (published == 0) return false;
+        cursor_ = published - 1;
+        started_ = true;
+    }
+    // The slot of frame `published` is being rewritten, so only the last
+    // slot_count - 1 frames are safe to start on
+    const uint64_t window = header_->slot_count - 1;
+    if (published > window && cursor_ < published - window) {
+        skipped_ += published - window - cursor_;
+        cursor_ = published - window;
+    }
+    while (cursor_ < published) {
+        if (read(cursor_++, out)) return true;
+        ++skipped_;  // overwritten while reading it
+    }
+    return false;
+}
+
+bool ShmFrameReader::valid(const ShmFrame& out) const {
+    if (!header_) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const ShmSlotHeader& slot = slots_[out.index % header_->slot_count];
+    return slot.seq.load(std::memory_order_relaxed) == 2 * out.index + 2;
+}
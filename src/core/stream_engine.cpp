@@ -0,0 +1,136 @@
+#include "core/stream_engine.hpp"
+#include <iostream>
+
+StreamEngine::Stream::Stream(const std::string& source,
+                             const FrameQueue::Options& queue_opts,
+                             const VideoCapture::Options& capture_opts)
+    : buffer(FrameQueue::create(queue_opts))
+    , capture(source, *buffer, capture_opts)
+    , consumer(*buffer, config_queue, results) {}
+
+StreamEngine::StreamEngine(size_t num_workers) : pool_(num_workers) {}
+
+StreamEngine::~StreamEngine() {
+    stop();
+}
+
+size_t StreamEngine::addStream(const std::string& source,
+                               const FrameQueue::Options& queue_opts,
+                               const VideoCapture::Options& capture_opts) {
+    streams_.push_back(std::make_unique<Stream>(source, queue_opts, capture_opts));
+    Stream& stream = *streams_.back();
+    stream.buffer->setPushListener([this, &stream] { schedule(stream); });
+    // Strips of a frame run on the same workers as the streams
+    stream.consumer.setWorkerPool(&pool_);
+    return streams_.size() - 1;
+}
+
+bool StreamEngine::start() {
+    for (size_t i = 0; i < streams_.size(); ++i) {
+        if (!streams_[i]->capture.start()) {
+            std::cerr << "Failed to start stream " << i << std::endl;
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void StreamEngine::stop() {
+    // Stop producers first, then let the pool finish the frames already queued
+    for (auto& stream : streams_) {
+        stream->capture.stop();
+    }
+    pool_.shutdown();
+    for (auto& stream : streams_) {
+        stream->consumer.finishEpisodes();
+        stream->consumer.saveCheckpoint();
+    }
+}
+
+/**
+ * Schedule a drain task unless one is already pending or running.
+ * The scheduled flag makes the stream an actor: at most one task touches
+ * its MotionDetector at a time, which keeps results in frame order.
+ */
+void StreamEngine::schedule(Stream& stream) {
+    if (stream.scheduled.exchange(true)) return;
+    pool_.submit([this, &stream] { run(stream); });
+}
+
+void StreamEngine::run(Stream& stream) {
+    stream.consumer.drain(kFramesPerTask);
+    stream.scheduled.store(false);
+
+    // A push that raced with the flag reset saw scheduled == true and did
+    // not submit, so re-check for leftover frames here.
+    if (stream.buffer->size() > 0) {
+        schedule(stream);
+    }
+}
+
+MotionDetectionConfigQueue& StreamEngine::configQueue(size_t stream) {
+    return streams_.at(stream)->config_queue;
+}
+
+MotionDetectionResultChannel& StreamEngine::results(size_t stream) {
+    return streams_.at(stream)->results;
+}
+
+const MotionConsumer& StreamEngine::consumer(size_t stream) const {
+    return streams_.at(stream)->consumer;
+}
+
+void StreamEngine::setDisplayRate(size_t stream, double fps) {
+    streams_.at(stream)->consumer.setDisplayRate(fps);
+}
+
+void StreamEngine::setPreviewRate(size_t stream, double fps) {
+    streams_.at(stream)->consumer.setPreviewRate(fps);
+}
+
+const VideoCapture& StreamEngine::capture(size_t stream) const {
+    return streams_.at(stream)->capture;
+}
+
+void StreamEngine::enableMetrics() {
+    for (size_t i = 0; i < streams_.size(); ++i) {
+        std::string labels = "stream=\"" + std::to_string(i) + "\"";
+        streams_[i]->capture.enableMetrics(labels);
+        streams_[i]->consumer.enableMetrics(labels);
+    }
+}
+
+FrameQueue& StreamEngine::buffer(size_t stream) {
+    return *streams_.at(stream)->buffer;
+}
+
+void StreamEngine::setEventLog(size_t stream, EventLog* log) {
+    streams_.at(stream)->consumer.setEventLog(log);
+}
+
+void StreamEngine::setClipRecorder(size_t stream, ClipRecorder* recorder) {
+    streams_.at(stream)->consumer.setClipRecorder(recorder);
+}
+
+void StreamEngine::setShmPublisher(size_t stream, ShmFramePublisher* publisher) {
+    streams_.at(stream)->consumer.setShmPublisher(publisher);
+}
+
+void StreamEngine::setCheckpointer(size_t stream, BackgroundCheckpointer* checkpointer) {
+    streams_.at(stream)->consumer.setCheckpointer(checkpointer);
+}
+
+void StreamEngine::setLoadGovernor(size_t stream, LoadGovernor* governor,
+                                   MotionConsumer::GovernorCallback callback) {
+    Stream& s = *streams_.at(stream);
+    s.consumer.setLoadGovernor(governor, &s.capture, std::move(callback));
+}
+
+void StreamEngine::setEpisodeOptions(size_t stream, const EpisodeDetector::Options& opts) {
+    streams_.at(stream)->consumer.setEpisodeOptions(opts);
+}
+
+void StreamEngine::setEpisodeCallback(size_t stream, MotionConsumer::EpisodeCallback callback) {
+    streams_.at(stream)->consumer.setEpisodeCallback(std::move(callback));
+}
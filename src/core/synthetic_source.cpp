@@ -0,0 +1,132 @@
+#include "core/synthetic_source.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const char kScheme[] = "synthetic://";
+
+// splitmix64: cheap, well-mixed values from (seed, n)
+uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+double unit(uint64_t seed, uint64_t n) {
+    return (mix(seed * 0x100000001b3ull + n) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+}  // namespace
+
+bool SyntheticSource::isSyntheticUri(const std::string& uri) {
+    return uri.compare(0, sizeof(kScheme) - 1, kScheme) == 0;
+}
+
+bool SyntheticSource::parse(const std::string& uri, Spec& spec) {
+    if (!isSyntheticUri(uri)) return false;
+    std::string rest = uri.substr(sizeof(kScheme) - 1);
+    std::string query;
+    size_t q = rest.find('?');
+    if (q != std::string::npos) {
+        query = rest.substr(q + 1);
+        rest.resize(q);
+    }
+
+    if (!rest.empty()) {
+        size_t at = rest.find('@');
+        std::string geometry = rest.substr(0, at);
+        if (!geometry.empty() &&
+            std::sscanf(geometry.c_str(), "%dx%d", &spec.width, &spec.height) != 2) {
+            return false;
+        }
+        if (at != std::string::npos) spec.fps = std::atof(rest.c_str() + at + 1);
+    }
+
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t amp = query.find('&', pos);
+        std::string pair = query.substr(pos, amp == std::string::npos ? std::string::npos : amp - pos);
+        pos = amp == std::string::npos ? query.size() : amp + 1;
+        size_t eq = pair.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = pair.substr(0, eq);
+        const char* value = pair.c_str() + eq + 1;
+        if (key == "blobs") spec.blobs = std::atoi(value);
+        else if (key == "noise") spec.noise = std::atof(value);
+        else if (key == "seed") spec.seed = std::strtoull(value, nullptr, 10);
+        else if (key == "size") spec.blob_size = std::atoi(value);
+        else if (key == "speed") spec.speed = std::atof(value);
+    }
+    return spec.width > 0 && spec.height > 0 && spec.blobs >= 0 && spec.fps >= 0;
+}
+
+SyntheticSource::SyntheticSource(const Spec& spec) : spec_(spec) {
+    blob_size_ = spec_.blob_size > 0 ? spec_.blob_size : std::max(4, spec_.height / 10);
+    blob_size_ = std::min({blob_size_, spec_.width, spec_.height});
+    double speed = spec_.speed > 0 ? spec_.speed : std::max(1.0, spec_.height / 120.0);
+
+    const double range_x = spec_.width - blob_size_;
+    const double range_y = spec_.height - blob_size_;
+    for (int i = 0; i < spec_.blobs; ++i) {
+        uint64_t n = static_cast<uint64_t>(i) * 8;
+        double angle = unit(spec_.seed, n + 2) * 2.0 * CV_PI;
+        // Alternate bright and dark so blobs contrast with the mid-gray texture
+        double level = (i % 2 == 0) ? 230.0 : 25.0;
+        blobs_.push_back(Blob{unit(spec_.seed, n) * range_x, unit(spec_.seed, n + 1) * range_y,
+                              speed * std::cos(angle), speed * std::sin(angle),
+                              cv::Scalar(level, 255.0 - level, level)});
+    }
+
+    // Smooth texture so the blur in the detector leaves structure behind
+    cv::RNG rng(spec_.seed);
+    cv::Mat texture(size(), CV_8UC3);
+    rng.fill(texture, cv::RNG::UNIFORM, 70, 180);
+    cv::GaussianBlur(texture, texture, cv::Size(9, 9), 0);
+
+    for (int k = 0; k < kNoiseFrames; ++k) {
+        cv::Mat noisy;
+        if (spec_.noise > 0) {
+            cv::Mat noise(size(), CV_16SC3);
+            rng.fill(noise, cv::RNG::NORMAL, 0.0, spec_.noise);
+            texture.convertTo(noisy, CV_16SC3);
+            noisy += noise;
+            noisy.convertTo(noisy, CV_8UC3);
+        } else {
+            noisy = texture.clone();
+        }
+        backgrounds_.push_back(noisy);
+    }
+}
+
+/** Position along one axis moving at velocity and reflecting inside [0, range] */
+double SyntheticSource::bounce(double start, double velocity, uint64_t index, double range) {
+    if (range <= 0) return 0;
+    double period = 2.0 * range;
+    double p = std::fmod(start + velocity * static_cast<double>(index), period);
+    if (p < 0) p += period;
+    return p <= range ? p : period - p;
+}
+
+cv::Rect SyntheticSource::blobRect(const Blob& b, uint64_t index) const {
+    int x = static_cast<int>(bounce(b.x0, b.vx, index, spec_.width - blob_size_));
+    int y = static_cast<int>(bounce(b.y0, b.vy, index, spec_.height - blob_size_));
+    return cv::Rect(x, y, blob_size_, blob_size_);
+}
+
+std::vector<cv::Rect> SyntheticSource::groundTruth(uint64_t index) const {
+    std::vector<cv::Rect> rects;
+    rects.reserve(blobs_.size());
+    for (const Blob& b : blobs_) rects.push_back(blobRect(b, index));
+    return rects;
+}
+
+void SyntheticSource::render(uint64_t index, cv::Mat& out) const {
+    backgrounds_[index % kNoiseFrames].copyTo(out);
+    for (const Blob& b : blobs_) {
+        out(blobRect(b, index)).setTo(b.color);
+    }
+}
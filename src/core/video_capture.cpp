@@ -1,17 +1,24 @@
 #include "core/video_capture.hpp"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 
 using namespace std::chrono;
 
 VideoCapture::VideoCapture(const std::string& source, FrameQueue& buffer)
-    : source_(source), buffer_(buffer) {
+    : VideoCapture(source, buffer, Options()) {}
+
+VideoCapture::VideoCapture(const std::string& source, FrameQueue& buffer,
+                           const Options& opts)
+    : source_(source), buffer_(buffer), opts_(opts) {
     source_type_ = detectSourceType(source);
 }
 
 VideoCapture::~VideoCapture() { stop(); }
 
 VideoCapture::SourceType VideoCapture::detectSourceType(const std::string& source) {
+    if (SyntheticSource::isSyntheticUri(source))
+        return SourceType::SYNTHETIC;
     if (source.find("rtsp://") == 0)
         return SourceType::RTSP;
     if (source.find("http://") == 0 || source.find("https://") == 0)
@@ -24,14 +31,38 @@ VideoCapture::SourceType VideoCapture::detectSourceType(const std::string& sourc
     }
 }
 
-bool VideoCapture::start() {
+bool VideoCapture::open() {
+    if (source_type_ == SourceType::SYNTHETIC) {
+        SyntheticSource::Spec spec;
+        if (!SyntheticSource::parse(source_, spec)) return false;
+        synthetic_ = std::make_unique<SyntheticSource>(spec);
+        // A few buffers cover the queue in steady state; more are pooled on demand
+        buffer_.pool().preallocate(synthetic_->size(), CV_8UC3, kPreallocatedFrames);
+        return true;
+    }
+
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+    std::vector<int> params;
+    if (opts_.decode_threads >= 0) {
+        params = {cv::CAP_PROP_N_THREADS, opts_.decode_threads};
+    }
     if (source_type_ == SourceType::CAMERA) {
-        cap_.open(std::stoi(source_));
-    } else {
-        cap_.open(source_);
+        return cap_.open(std::stoi(source_), cv::CAP_ANY, params);
     }
-    
-    if (!cap_.isOpened()) {
+    return cap_.open(source_, cv::CAP_ANY, params);
+#else
+    if (opts_.decode_threads >= 0) {
+        std::cerr << "Decode threads need OpenCV 4.6+, using backend default" << std::endl;
+    }
+    if (source_type_ == SourceType::CAMERA) {
+        return cap_.open(std::stoi(source_));
+    }
+    return cap_.open(source_);
+#endif
+}
+
+bool VideoCapture::start() {
+    if (!open()) {
         std::cerr << "Failed to open: " << source_ << std::endl;
         return false;
     }
@@ -41,21 +72,64 @@ bool VideoCapture::start() {
     return true;
 }
 
+/** Advances the analysis schedule; stride is in source frames */
+bool VideoCapture::shouldAnalyze(uint64_t index, double stride) {
+    if (index < next_analysis_) return false;
+    next_analysis_ += stride;
+    // Resync after a jump (source reopened or rewound)
+    if (next_analysis_ <= index) next_analysis_ = index + stride;
+    return true;
+}
+
 void VideoCapture::captureLoop() {
- double fps = cap_.get(cv::CAP_PROP_FPS);
-    if (fps <= 0) fps = 30.0;
+    double fps = 0.0;  // synthetic sources may run unpaced
+    if (synthetic_) {
+        fps = synthetic_->spec().fps;
+    } else {
+        fps = cap_.get(cv::CAP_PROP_FPS);
+        if (fps <= 0) fps = 30.0;
+    }
     
-    auto frame_duration = std::chrono::milliseconds(static_cast<int>(1000.0 / fps));
+    auto frame_duration = std::chrono::microseconds(
+        fps > 0 ? static_cast<int64_t>(1e6 / fps) : 0);
+    double stride = opts_.analysis_fps > 0.0
+        ? std::max(1.0, fps / opts_.analysis_fps)
+        : static_cast<double>(std::max(1, opts_.analyze_every));
+    cv::Size frame_size = synthetic_ ? synthetic_->size() : cv::Size();
+    int frame_type = CV_8UC3;
     
     while (running_) {
         auto frame_start = std::chrono::steady_clock::now();
         
+        // grab() demuxes/decodes; retrieve() converts and copies, so it only
+        // runs for frames that will be analyzed
+        bool ok = synthetic_ ? true : cap_.grab();
+        auto grabbed = std::chrono::steady_clock::now();
+        int64_t grab_ns = duration_cast<nanoseconds>(grabbed - frame_start).count();
+        grab_ns_ += grab_ns;
+        if (grab_hist_) grab_hist_->record(grab_ns);
         cv::Mat frame;
-        if (!cap_.read(frame) || frame.empty()) {
+        uint64_t index = frame_count_;
+        const int divisor = analysis_divisor_.load(std::memory_order_relaxed);
+        bool analyze = ok && shouldAnalyze(index, stride * divisor);
+        if (analyze) {
+            // retrieve() decodes into the pooled buffer when the geometry matches
+            frame = buffer_.pool().acquire(frame_size, frame_type);
+            if (synthetic_) {
+                synthetic_->render(index, frame);
+            } else {
+                ok = cap_.retrieve(frame) && !frame.empty();
+            }
+            int64_t retrieve_ns = duration_cast<nanoseconds>(
+                std::chrono::steady_clock::now() - grabbed).count();
+            retrieve_ns_ += retrieve_ns;
+            if (retrieve_hist_) retrieve_hist_->record(retrieve_ns);
+        }
+        if (!ok) {
             if (source_type_ == SourceType::RTSP ||
                 source_type_ == SourceType::HTTP) {
                 std::this_thread::sleep_for(std::chrono::seconds(1));
-                cap_.open(source_);
+                open();
                 continue;
             }
             
@@ -66,11 +140,21 @@ void VideoCapture::captureLoop() {
             
             break;
         }
+        ++frame_count_;
         
-        auto ts = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::steady_clock::now().time_since_epoch()).count();
-        
-        buffer_.push(TimestampedFrame{std::move(frame), ts, frame_count_++});
+        if (analyze) {
+            frame_size = frame.size();
+            frame_type = frame.type();
+            ++retrieved_;
+            
+            auto ts = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            
+            // frame_id is the source frame index, so skipped frames leave gaps
+            buffer_.push(TimestampedFrame{std::move(frame), ts, index, metricsNow()});
+        } else {
+            ++skipped_;
+        }
         
         // Sleep to maintain FPS
         auto elapsed = std::chrono::steady_clock::now() - frame_start;
@@ -80,6 +164,24 @@ void VideoCapture::captureLoop() {
     }
 }
 
+void VideoCapture::enableMetrics(const std::string& labels) {
+    MetricsRegistry& registry = MetricsRegistry::global();
+    grab_hist_ = &registry.histogram("motion_capture_grab_seconds",
+        "Time in VideoCapture::grab() (demux and decode)", labels);
+    retrieve_hist_ = &registry.histogram("motion_capture_retrieve_seconds",
+        "Time in VideoCapture::retrieve() (convert and copy)", labels);
+}
+
+VideoCapture::Stats VideoCapture::stats() const {
+    Stats s;
+    s.grabbed = frame_count_;
+    s.skipped = skipped_;
+    s.retrieved = retrieved_;
+    s.grab_ms = grab_ns_ / 1e6;
+    s.retrieve_ms = retrieve_ns_ / 1e6;
+    return s;
+}
+
 void VideoCapture::stop() {
     running_ = false;
     buffer_.shutdown();
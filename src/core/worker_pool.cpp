@@ -0,0 +1,149 @@
+#include "core/worker_pool.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+// Index of the pool worker running on this thread, or npos for outside threads
+thread_local const WorkerPool* tls_pool = nullptr;
+thread_local size_t tls_index = static_cast<size_t>(-1);
+}
+
+WorkerPool::WorkerPool(size_t num_workers) {
+    if (num_workers == 0) {
+        num_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers_[i]->thread = std::thread(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+void WorkerPool::submit(Task task) {
+    const bool from_worker = tls_pool == this;
+    size_t target = from_worker
+        ? tls_index
+        : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    {
+        // Pair with the predicate check in workerLoop so no wakeup is lost,
+        // and so a worker can't exit between the stopping_ check and the push
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        // Workers drain what they submit during shutdown; anyone else is late
+        if (!stopping_ || from_worker) {
+            {
+                std::lock_guard<std::mutex> worker_lock(workers_[target]->mutex);
+                workers_[target]->tasks.push_back(std::move(task));
+            }
+            pending_.fetch_add(1, std::memory_order_release);
+            task = nullptr;
+        }
+    }
+    if (task) {
+        // The workers may be gone: run it here so waiters on it still finish
+        assert(!"WorkerPool::submit() after shutdown()");
+        task();
+        return;
+    }
+    idle_cv_.notify_one();
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    // Helpers that start after every index is taken only touch this state
+    struct Loop {
+        std::function<void(size_t)> fn;
+        size_t count;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        void run() {
+            size_t finished = 0;
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+                fn(i);
+                ++finished;
+            }
+            if (finished && done.fetch_add(finished, std::memory_order_acq_rel) + finished == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+            }
+        }
+    };
+    auto loop = std::make_shared<Loop>();
+    loop->fn = fn;
+    loop->count = count;
+
+    const size_t helpers = std::min(count - 1, workers_.size());
+    for (size_t h = 0; h < helpers; ++h) {
+        submit([loop] { loop->run(); });
+    }
+    loop->run();
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->cv.wait(lock, [&] { return loop->done.load(std::memory_order_acquire) == count; });
+}
+
+void WorkerPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    idle_cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+bool WorkerPool::popLocal(size_t index, Task& task) {
+    Worker& w = *workers_[index];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.tasks.empty()) return false;
+    task = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool WorkerPool::steal(size_t thief, Task& task) {
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(thief + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkerPool::workerLoop(size_t index) {
+    tls_pool = this;
+    tls_index = index;
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_cv_.wait(lock, [this] {
+            return pending_.load(std::memory_order_acquire) > 0 || stopping_;
+        });
+        if (stopping_ && pending_.load(std::memory_order_acquire) == 0) break;
+    }
+}
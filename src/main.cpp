@@ -1,11 +1,27 @@
 #include "queues/frame_queue.hpp"
 #include "core/video_capture.hpp"
 #include "core/motion_consumer.hpp"
+#include "core/stream_engine.hpp"
+#include "core/batch_runner.hpp"
+#include "core/motion_kernels.hpp"
+#include "core/overlay.hpp"
+#include "core/metrics.hpp"
+#include "core/clip_recorder.hpp"
+#include "core/shm_frame_publisher.hpp"
+#include "core/preview_server.hpp"
+#include "core/background_checkpoint.hpp"
+#include "core/load_governor.hpp"
 #include "queues/mdcfg_queue.hpp"
 #include "queues/mdresult_queue.hpp"
 #include "models/detection_result.hpp"
 #include <iostream>
+#include <memory>
 #include <csignal>
+#include <cctype>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <chrono>
 
 std::atomic<bool> g_running{true};
 void signalHandler(int) { g_running = false; }
@@ -18,8 +34,17 @@ int roi_height = 60;
 int threshold = 25;
 int min_contour_area = 10;  // Scaled: actual = value * 100
 
+// Settings from the command line that the sliders don't cover
+MotionDetectorConfig base_config;
+
+std::vector<std::string> roiNames() {
+    std::vector<std::string> names;
+    for (const auto& roi : base_config.rois) names.push_back(roi.name);
+    return names;
+}
+
 MotionDetectorConfig buildConfig() {
-    MotionDetectorConfig cfg;
+    MotionDetectorConfig cfg = base_config;
     cfg.roi.center_x = roi_center_x / 100.0f;
     cfg.roi.center_y = roi_center_y / 100.0f;
     cfg.roi.width_ratio = std::max(0.05f, roi_width / 100.0f);
@@ -29,20 +54,667 @@ MotionDetectorConfig buildConfig() {
     return cfg;
 }
 
+struct Options {
+    std::vector<std::string> sources;
+    std::string output = "motion_data.csv";
+    bool multi = false;
+    bool batch = false;
+    bool headless = false;
+    double display_fps = 30.0;
+    size_t segments = 0;  // batch: 0 = one per worker
+    size_t warmup = 150;
+    size_t workers = 0;  // 0 = one per core
+    FrameQueue::Options queue;
+    VideoCapture::Options capture;
+    EventLog::Options log;
+    MetricsExporter::Options metrics;
+    EpisodeDetector::Options episodes;
+    bool record_clips = false;
+    ClipRecorder::Options clips;
+    std::string shm_name;  // empty = no shared-memory publication
+    PreviewServer::Options preview;  // port 0 = no preview server
+    BackgroundCheckpointer::Options checkpoint;  // empty path = none
+    bool govern = false;
+    LoadGovernor::Options governor;
+};
+
+// Clip encoding runs on its own small pool, off the detection workers
+constexpr size_t kClipEncodeWorkers = 2;
+
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [options] [source ...]\n"
+              << "       " << prog << " <source> [output.csv]\n"
+              << "  -o, --output PATH  Event log (per stream: PATH_<n>.csv); a .mdlog\n"
+              << "                     extension selects the binary columnar format\n"
+              << "  --multi            Run sources on the shared worker pool\n"
+              << "  --workers N        Worker pool size (default: cores)\n"
+              << "  --queue POLICY     Full-queue policy: block, drop-oldest,\n"
+              << "                     drop-newest, latest (default: block)\n"
+              << "  --lockfree         Lock-free frame ring instead of mutex queue\n"
+              << "  --scale F          Detect on the ROI downscaled by F (0 < F <= 1)\n"
+              << "  --pyramid N        Detect N pyramid levels down (overrides --scale)\n"
+              << "  --refine           Re-measure the largest box at full resolution\n"
+              << "  --headless         No window; log only until Ctrl-C\n"
+              << "  --display-fps N    Frames per second sent to the window (default 30)\n"
+              << "  --roi SPEC         Add a named ROI (repeatable; replaces the ROI sliders):\n"
+              << "                     name:cx,cy,w,h[,threshold[,min_area]] as frame ratios\n"
+              << "  --tile N           Change-gating tile size in pixels, 0 = off (default 16)\n"
+              << "  --fixed-bg         8.8 fixed-point background (half the memory traffic)\n"
+              << "  --full-bg          Model the whole frame so ROI edits need no re-learning\n"
+              << "  --strips N         Split each frame into N strips detected in parallel\n"
+              << "  --every N          Analyze every Nth source frame (others are only grabbed)\n"
+              << "  --analysis-fps F   Analyze at most F frames/sec of source time\n"
+              << "  --decode-threads N Backend decode threads, 0 = all cores\n"
+              << "  --metrics PATH     Write Prometheus metrics to PATH periodically\n"
+              << "  --metrics-socket P Serve Prometheus metrics on unix socket P\n"
+              << "  --metrics-interval MS  Metrics file refresh period (default 5000)\n"
+              << "  --episode-gap MS   Quiet time that ends a motion episode (default 1000)\n"
+              << "  --episode-threshold S  Motion score (%) that starts an episode\n"
+              << "                     (default: adaptive, 2 sigma over the quiet mean)\n"
+              << "  --clips DIR        Record motion episodes as MJPEG clips into DIR\n"
+              << "  --pre-roll S       Seconds kept before an episode (default 3)\n"
+              << "  --post-roll S      Seconds recorded after it ends (default 2)\n"
+              << "  --clip-mb N        Per-stream cap on buffered JPEG frames (default 32)\n"
+              << "  --shm NAME         Publish frames, masks and events to POSIX shared\n"
+              << "                     memory NAME (per stream: NAME_<n>); read with\n"
+              << "                     motion_shm_tail\n"
+              << "  --checkpoint PATH  Save background models to PATH (per stream:\n"
+              << "                     PATH_<n>) and restore them on startup\n"
+              << "  --checkpoint-interval S  Seconds between checkpoints (default 60)\n"
+              << "  --governor         Under overload, step down processing scale, analysis\n"
+              << "                     rate, blur and visualization; restore as load allows\n"
+              << "  --governor-load F  Processing busy fraction that counts as overload\n"
+              << "                     (default 0.85)\n"
+              << "  --preview-port N   Serve an MJPEG preview on http://127.0.0.1:N/\n"
+              << "  --preview-bind A   Preview listen address (default 127.0.0.1)\n"
+              << "  --preview-fps F    Preview frames per second (default 5)\n"
+              << "  --batch            Headless, full-speed processing of a video file\n"
+              << "  --segments N       Batch: split the file into N parallel segments\n"
+              << "  --warmup N         Batch: background warm-up frames per segment\n"
+              << "  --rotate-mb N      Start a new CSV segment every N MB (default 64)\n"
+              << "  --keep-files N     Keep only the newest N segments (default: all)\n"
+              << "Sources: camera index, file, rtsp://, http(s)://, or a generated test\n"
+              << "  stream synthetic://WxH@FPS?blobs=N&noise=SIGMA&seed=S&size=PX&speed=PX\n";
+}
+
+bool parsePolicy(const std::string& name, OverflowPolicy& policy) {
+    if (name == "block") policy = OverflowPolicy::BLOCK;
+    else if (name == "drop-oldest") policy = OverflowPolicy::DROP_OLDEST;
+    else if (name == "drop-newest") policy = OverflowPolicy::DROP_NEWEST;
+    else if (name == "latest") policy = OverflowPolicy::LATEST_ONLY;
+    else return false;
+    return true;
+}
+
+bool parseRoi(const std::string& spec, ROIConfig& roi) {
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos) return false;
+    roi.name = spec.substr(0, colon);
+    float threshold = -1, min_area = -1;
+    int n = std::sscanf(spec.c_str() + colon + 1, "%f,%f,%f,%f,%f,%f",
+                        &roi.center_x, &roi.center_y, &roi.width_ratio, &roi.height_ratio,
+                        &threshold, &min_area);
+    roi.threshold = static_cast<int>(threshold);
+    roi.min_contour_area = static_cast<int>(min_area);
+    return n >= 4;
+}
+
+bool parseArgs(int argc, char** argv, Options& opts) {
+    bool output_set = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            opts.output = argv[++i];
+            output_set = true;
+        } else if (arg == "--multi") {
+            opts.multi = true;
+        } else if (arg == "--workers" && i + 1 < argc) {
+            opts.workers = std::stoul(argv[++i]);
+            opts.multi = true;
+        } else if (arg == "--queue" && i + 1 < argc) {
+            if (!parsePolicy(argv[++i], opts.queue.policy)) {
+                std::cerr << "Unknown queue policy: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (arg == "--lockfree") {
+            opts.queue.lock_free = true;
+        } else if (arg == "--scale" && i + 1 < argc) {
+            base_config.process_scale = std::stod(argv[++i]);
+        } else if (arg == "--pyramid" && i + 1 < argc) {
+            base_config.pyramid_levels = std::stoi(argv[++i]);
+        } else if (arg == "--refine") {
+            base_config.refine = true;
+        } else if (arg == "--roi" && i + 1 < argc) {
+            ROIConfig roi;
+            if (!parseRoi(argv[++i], roi)) {
+                std::cerr << "Bad ROI spec: " << argv[i] << std::endl;
+                return false;
+            }
+            base_config.rois.push_back(roi);
+        } else if (arg == "--tile" && i + 1 < argc) {
+            base_config.tile_size = std::stoi(argv[++i]);
+        } else if (arg == "--fixed-bg") {
+            base_config.fixed_point = true;
+        } else if (arg == "--full-bg") {
+            base_config.full_frame_background = true;
+        } else if (arg == "--strips" && i + 1 < argc) {
+            base_config.strips = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--every" && i + 1 < argc) {
+            opts.capture.analyze_every = std::stoi(argv[++i]);
+        } else if (arg == "--analysis-fps" && i + 1 < argc) {
+            opts.capture.analysis_fps = std::stod(argv[++i]);
+        } else if (arg == "--decode-threads" && i + 1 < argc) {
+            opts.capture.decode_threads = std::stoi(argv[++i]);
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            opts.metrics.path = argv[++i];
+        } else if (arg == "--metrics-socket" && i + 1 < argc) {
+            opts.metrics.socket_path = argv[++i];
+        } else if (arg == "--metrics-interval" && i + 1 < argc) {
+            opts.metrics.interval_ms = std::stoi(argv[++i]);
+        } else if (arg == "--episode-gap" && i + 1 < argc) {
+            opts.episodes.gap_ms = std::stoll(argv[++i]);
+        } else if (arg == "--episode-threshold" && i + 1 < argc) {
+            opts.episodes.threshold = std::stod(argv[++i]);
+        } else if (arg == "--clips" && i + 1 < argc) {
+            opts.record_clips = true;
+            opts.clips.directory = argv[++i];
+        } else if (arg == "--pre-roll" && i + 1 < argc) {
+            opts.clips.pre_seconds = std::stod(argv[++i]);
+        } else if (arg == "--post-roll" && i + 1 < argc) {
+            opts.clips.post_seconds = std::stod(argv[++i]);
+        } else if (arg == "--clip-mb" && i + 1 < argc) {
+            opts.clips.max_bytes = std::stoul(argv[++i]) * 1024 * 1024;
+        } else if (arg == "--shm" && i + 1 < argc) {
+            opts.shm_name = argv[++i];
+            if (opts.shm_name[0] != '/') opts.shm_name = "/" + opts.shm_name;
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            opts.checkpoint.path = argv[++i];
+        } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+            opts.checkpoint.interval_ms = static_cast<int>(std::stod(argv[++i]) * 1000);
+        } else if (arg == "--governor") {
+            opts.govern = true;
+        } else if (arg == "--governor-load" && i + 1 < argc) {
+            opts.govern = true;
+            opts.governor.high_load = std::stod(argv[++i]);
+        } else if (arg == "--preview-port" && i + 1 < argc) {
+            opts.preview.port = std::stoi(argv[++i]);
+        } else if (arg == "--preview-bind" && i + 1 < argc) {
+            opts.preview.bind_address = argv[++i];
+        } else if (arg == "--preview-fps" && i + 1 < argc) {
+            opts.preview.fps = std::stod(argv[++i]);
+        } else if (arg == "--headless") {
+            opts.headless = true;
+        } else if (arg == "--display-fps" && i + 1 < argc) {
+            opts.display_fps = std::stod(argv[++i]);
+        } else if (arg == "--batch") {
+            opts.batch = true;
+        } else if (arg == "--segments" && i + 1 < argc) {
+            opts.segments = std::stoul(argv[++i]);
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            opts.warmup = std::stoul(argv[++i]);
+        } else if (arg == "--rotate-mb" && i + 1 < argc) {
+            opts.log.max_file_bytes = std::stoul(argv[++i]) * 1024 * 1024;
+        } else if (arg == "--keep-files" && i + 1 < argc) {
+            opts.log.max_files = std::stoul(argv[++i]);
+        } else if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (arg.size() > 1 && arg[0] == '-' && !std::isdigit(arg[1])) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else {
+            opts.sources.push_back(arg);
+        }
+    }
+
+    // Legacy form: <source> <output.csv>
+    if (!output_set && !opts.multi && !opts.batch && opts.sources.size() == 2) {
+        opts.output = opts.sources.back();
+        opts.sources.pop_back();
+    }
+    if (opts.sources.empty()) opts.sources.push_back("0");
+    size_t ext = opts.output.size() >= 6 ? opts.output.size() - 6 : 0;
+    if (opts.output.compare(ext, std::string::npos, ".mdlog") == 0) {
+        opts.log.format = EventLog::Format::BINARY;
+    }
+    if (opts.sources.size() > 1 && !opts.batch) opts.multi = true;
+    return true;
+}
+
+bool metricsRequested(const Options& opts) {
+    return !opts.metrics.path.empty() || !opts.metrics.socket_path.empty();
+}
+
+std::string streamOutputPath(const std::string& output, size_t stream) {
+    size_t dot = output.find_last_of('.');
+    std::string stem = dot == std::string::npos ? output : output.substr(0, dot);
+    std::string ext = dot == std::string::npos ? "" : output.substr(dot);
+    return stem + "_" + std::to_string(stream) + ext;
+}
+
+void setupWindow() {
+    cv::namedWindow("Motion Detector", cv::WINDOW_NORMAL);
+    cv::resizeWindow("Motion Detector", 1280, 720);
+    cv::moveWindow("Motion Detector", 100, 100);
+    
+    cv::createTrackbar("ROI X", "Motion Detector", &roi_center_x, 100);
+    cv::createTrackbar("ROI Y", "Motion Detector", &roi_center_y, 100);
+    cv::createTrackbar("ROI Width", "Motion Detector", &roi_width, 100);
+    cv::createTrackbar("ROI Height", "Motion Detector", &roi_height, 100);
+    cv::createTrackbar("Threshold", "Motion Detector", &threshold, 100);
+    cv::createTrackbar("Min Area", "Motion Detector", &min_contour_area, 300);
+}
+
+using ResultSubscriber = MotionDetectionResultChannel::Subscriber;
+using ResultPtr = MotionDetectionResultChannel::Ptr;
+
+/**
+ * Reads everything pending and keeps the newest result that carries a
+ * frame, so rate-limited frames aren't lost behind frameless results.
+ */
+bool popDisplayable(ResultSubscriber& subscriber, ResultPtr& out) {
+    bool found = false;
+    while (ResultPtr result = subscriber.tryNext()) {
+        if (!result->frame.empty()) {
+            out = std::move(result);
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool configChanged(const MotionDetectorConfig& current, const MotionDetectorConfig& last) {
+    return current.roi.center_x != last.roi.center_x ||
+           current.roi.center_y != last.roi.center_y ||
+           current.roi.width_ratio != last.roi.width_ratio ||
+           current.roi.height_ratio != last.roi.height_ratio ||
+           current.threshold != last.threshold ||
+           current.min_contour_area != last.min_contour_area;
+}
+
+void printFinalSettings() {
+    std::cout << "\n=== Final Settings ===\n";
+    std::cout << "roi.center_x = " << roi_center_x / 100.0f << "f;\n";
+    std::cout << "roi.center_y = " << roi_center_y / 100.0f << "f;\n";
+    std::cout << "roi.width_ratio = " << roi_width / 100.0f << "f;\n";
+    std::cout << "roi.height_ratio = " << roi_height / 100.0f << "f;\n";
+    std::cout << "threshold = " << threshold << ";\n";
+    std::cout << "min_contour_area = " << min_contour_area * 100 << ";\n";
+}
+
+void printLogStats(const EventLog& log) {
+    std::cout << "  events: written " << log.written() << ", dropped " << log.dropped()
+              << " (last segment " << log.currentPath() << ")\n";
+}
+
+std::string roiLabel(int index, const std::vector<std::string>& names) {
+    if (index >= 0 && static_cast<size_t>(index) < names.size() && !names[index].empty()) {
+        return names[index];
+    }
+    return "roi " + std::to_string(index);
+}
+
+/** Prints one finished episode; called from processing threads */
+void printEpisode(size_t stream, const MotionEpisode& e, const std::vector<std::string>& names) {
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "[stream %zu] episode %s: frames %llu-%llu (%.1f s), peak %.2f%% at frame %llu,"
+                  " mean %.2f%%\n",
+                  stream, roiLabel(e.roi_index, names).c_str(),
+                  static_cast<unsigned long long>(e.start_frame),
+                  static_cast<unsigned long long>(e.end_frame), e.durationMs() / 1000.0,
+                  e.peak_score, static_cast<unsigned long long>(e.peak_frame), e.mean_score);
+    std::fputs(line, stdout);  // one call, so lines from streams don't interleave
+    std::fflush(stdout);
+}
+
+/** Prints one governor level change; called from processing threads */
+void printGovernorTransition(size_t stream, const LoadGovernor::Transition& t) {
+    const auto& ladder = LoadGovernor::ladder();
+    char line[320];
+    std::snprintf(line, sizeof(line), "[stream %zu] governor %s to level %d (%s) at frame %llu: %s\n",
+                  stream, t.to > t.from ? "down" : "up", t.to,
+                  t.to > t.from ? ladder[t.to].name : ladder[t.from].name,
+                  static_cast<unsigned long long>(t.frame_id), t.reason.c_str());
+    std::fputs(line, stdout);
+    std::fflush(stdout);
+}
+
+void printGovernorStats(const LoadGovernor& governor) {
+    std::cout << "  governor: level " << governor.level() << " (" << governor.rung().name
+              << "), " << governor.transitions() << " transitions, last load "
+              << governor.lastLoadMilli() / 1000.0 << "\n";
+}
+
+void printMotionStats(const MotionConsumer& consumer, const std::vector<std::string>& names) {
+    for (const auto& s : consumer.statsSummary()) {
+        std::printf("  %s: %llu frames, score mean %.3f sd %.3f (recent %.3f / %.3f),"
+                    " p50 %.3f p95 %.3f p99 %.3f max %.3f, %llu episodes\n",
+                    roiLabel(s.roi_index, names).c_str(),
+                    static_cast<unsigned long long>(s.frames), s.mean, s.stddev,
+                    s.recent_mean, s.recent_stddev, s.p50, s.p95, s.p99, s.max,
+                    static_cast<unsigned long long>(s.episodes));
+    }
+    std::fflush(stdout);
+}
+
+void printClipStats(const ClipRecorder& recorder) {
+    ClipRecorder::Stats stats = recorder.stats();
+    std::cout << "  clips: " << stats.clips << " written, " << stats.frames_written << " frames, "
+              << stats.bytes_written / 1e6 << " MB at " << stats.writeMBps() << " MB/s; encoded "
+              << stats.frames_encoded << " ("
+              << (stats.frames_encoded ? stats.encode_ms / stats.frames_encoded : 0.0)
+              << " ms/frame), skipped " << stats.encode_dropped << ", evicted unwritten "
+              << stats.evicted_unwritten << "\n";
+}
+
+void printShmStats(const ShmFramePublisher& publisher) {
+    ShmFramePublisher::Stats stats = publisher.stats();
+    std::cout << "  shm " << publisher.name() << ": published " << stats.published
+              << ", skipped " << stats.skipped << "\n";
+}
+
+void printCheckpointStats(const BackgroundCheckpointer& checkpointer, const MotionConsumer& consumer) {
+    BackgroundCheckpointer::Stats stats = checkpointer.stats();
+    std::cout << "  checkpoint " << checkpointer.path() << ": restored " << consumer.restoredModels()
+              << " of " << stats.loaded_models << " models (load " << stats.load_ms
+              << " ms); written " << stats.written << " (" << stats.bytes / 1e6 << " MB, snapshot "
+              << (stats.written ? stats.snapshot_ms / stats.written : 0.0) << " ms, write "
+              << (stats.written ? stats.write_ms / stats.written : 0.0) << " ms), skipped "
+              << stats.skipped << ", failed " << stats.failed << "\n";
+}
+
+void printPreviewStats(const PreviewServer& preview) {
+    PreviewServer::Stats stats = preview.stats();
+    std::cout << "Preview: " << stats.connections << " connections, encoded "
+              << stats.frames_encoded << " ("
+              << (stats.frames_encoded ? stats.encode_ms / stats.frames_encoded : 0.0)
+              << " ms/frame), sent " << stats.frames_sent << ", dropped for slow clients "
+              << stats.frames_dropped << "\n";
+}
+
+bool startPreview(PreviewServer& preview, const Options& opts) {
+    if (opts.preview.port <= 0) return true;
+    if (!preview.start()) return false;
+    std::cout << "Preview on http://" << opts.preview.bind_address << ":" << preview.port()
+              << "/\n";
+    return true;
+}
+
+void printCaptureStats(const VideoCapture& capture) {
+    VideoCapture::Stats stats = capture.stats();
+    std::cout << "  capture: grabbed " << stats.grabbed << ", skipped " << stats.skipped
+              << ", retrieved " << stats.retrieved << "; grab " << stats.grab_ms
+              << " ms, retrieve " << stats.retrieve_ms << " ms\n";
+}
+
+void printQueueStats(FrameQueue& buffer, const MotionConsumer& consumer) {
+    FrameQueue::Stats stats = buffer.stats();
+    std::cout << "  frames: pushed " << stats.pushed << ", popped " << stats.popped
+              << ", dropped oldest " << stats.dropped_oldest
+              << " / newest " << stats.dropped_newest
+              << " / stale " << stats.dropped_stale << "\n";
+    std::cout << "  buffer allocations: capture " << buffer.pool().allocations()
+              << " (reused " << buffer.pool().reuses() << "), detector scratch "
+              << consumer.detectorAllocations() << " (excludes labeling)\n";
+    uint64_t tiles = consumer.tilesProcessed() + consumer.tilesSkipped();
+    if (tiles > 0) {
+        std::cout << "  tiles: processed " << consumer.tilesProcessed() << ", skipped "
+                  << consumer.tilesSkipped() << " ("
+                  << 100.0 * consumer.tilesSkipped() / tiles << "%)\n";
+    }
+}
+
+/**
+ * Batch mode: no window, no pacing, stops at end of file. Uses the
+ * initial slider values as the detector config.
+ */
+int runBatch(const Options& opts) {
+    EventLog::Options log_opts = opts.log;
+    log_opts.path = opts.output;
+    EventLog event_log(log_opts);
+    if (!event_log.start()) return 1;
+
+    BatchRunner::Options batch_opts;
+    batch_opts.path = opts.sources.front();
+    batch_opts.segments = opts.segments;
+    batch_opts.workers = opts.workers;
+    batch_opts.warmup_frames = opts.warmup;
+    batch_opts.config = buildConfig();
+
+    BatchRunner runner(batch_opts);
+    BatchRunner::Report report;
+    bool ok = runner.run(event_log, report);
+    event_log.stop();
+
+    std::cout << "Processed " << report.frames << " frames (" << report.decoded
+              << " decoded incl. warm-up) in " << report.segments << " segments, "
+              << report.seconds << " s, " << report.fps() << " frames/sec\n";
+    printLogStats(event_log);
+    return ok ? 0 : 1;
+}
+
+/**
+ * Multi-stream mode: all sources share one worker pool. Slider changes are
+ * sent to every stream; 'n' cycles which stream is displayed.
+ */
+int runMultiStream(const Options& opts) {
+    // Outlive the engine: its stop() writes the last checkpoints
+    std::vector<std::unique_ptr<BackgroundCheckpointer>> checkpointers;
+    std::vector<std::unique_ptr<LoadGovernor>> governors;
+    StreamEngine engine(opts.workers);
+    for (const auto& source : opts.sources) {
+        engine.addStream(source, opts.queue, opts.capture);
+    }
+    std::vector<std::unique_ptr<EventLog>> logs;
+    std::unique_ptr<WorkerPool> clip_pool;
+    if (opts.record_clips) clip_pool = std::make_unique<WorkerPool>(kClipEncodeWorkers);
+    std::vector<std::unique_ptr<ClipRecorder>> recorders;
+    std::vector<std::unique_ptr<ShmFramePublisher>> publishers;
+    for (size_t i = 0; i < engine.streamCount(); ++i) {
+        if (!opts.checkpoint.path.empty()) {
+            BackgroundCheckpointer::Options cp_opts = opts.checkpoint;
+            cp_opts.path = streamOutputPath(opts.checkpoint.path, i);
+            checkpointers.push_back(std::make_unique<BackgroundCheckpointer>(cp_opts));
+            checkpointers.back()->start();
+            engine.setCheckpointer(i, checkpointers.back().get());
+        }
+        if (opts.govern) {
+            governors.push_back(std::make_unique<LoadGovernor>(opts.governor));
+            engine.setLoadGovernor(i, governors.back().get(),
+                                   [i](const LoadGovernor::Transition& t) {
+                printGovernorTransition(i, t);
+            });
+        }
+        if (!opts.shm_name.empty()) {
+            ShmFramePublisher::Options shm_opts;
+            shm_opts.name = opts.shm_name + "_" + std::to_string(i);
+            publishers.push_back(std::make_unique<ShmFramePublisher>(shm_opts));
+            engine.setShmPublisher(i, publishers.back().get());
+        }
+        if (opts.record_clips) {
+            ClipRecorder::Options clip_opts = opts.clips;
+            clip_opts.prefix = "stream" + std::to_string(i);
+            recorders.push_back(std::make_unique<ClipRecorder>(clip_opts, *clip_pool));
+            if (!recorders.back()->start()) return 1;
+            engine.setClipRecorder(i, recorders.back().get());
+        }
+        EventLog::Options log_opts = opts.log;
+        log_opts.path = streamOutputPath(opts.output, i);
+        logs.push_back(std::make_unique<EventLog>(log_opts));
+        if (!logs.back()->start()) return 1;
+        engine.setEventLog(i, logs.back().get());
+        engine.setEpisodeOptions(i, opts.episodes);
+        engine.setEpisodeCallback(i, [i, names = roiNames()](const MotionEpisode& e) {
+            printEpisode(i, e, names);
+        });
+        engine.configQueue(i).push(buildConfig());
+    }
+    PreviewServer::Options preview_opts = opts.preview;
+    preview_opts.roi_names = roiNames();
+    PreviewServer preview(preview_opts);
+    for (size_t i = 0; i < engine.streamCount(); ++i) {
+        preview.addStream(engine.results(i), [&engine, i](double fps) {
+            engine.setPreviewRate(i, fps);
+        });
+    }
+    if (metricsRequested(opts)) engine.enableMetrics();
+    if (!startPreview(preview, opts)) return 1;
+    if (!engine.start()) {
+        std::cerr << "Failed to start capture" << std::endl;
+        return 1;
+    }
+    std::cout << "Running " << engine.streamCount() << " streams on "
+              << engine.workerCount() << " workers\n";
+
+    size_t shown = 0;
+    for (size_t i = 0; i < engine.streamCount(); ++i) {
+        engine.setDisplayRate(i, !opts.headless && i == shown ? opts.display_fps : 0.0);
+    }
+    if (!opts.headless) setupWindow();
+    MotionDetectorConfig last_config = buildConfig();
+    // Only the shown stream has a display subscriber; the others publish
+    // into their rings without anyone reading
+    std::unique_ptr<ResultSubscriber> display_sub;
+    if (!opts.headless) display_sub = engine.results(shown).subscribe();
+    ResultPtr display;
+    cv::Mat overlay;
+    const std::vector<std::string> roi_names = roiNames();
+
+    while (g_running) {
+        if (opts.headless) {
+            // No window or sliders
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        MotionDetectorConfig current = buildConfig();
+        if (configChanged(current, last_config)) {
+            for (size_t i = 0; i < engine.streamCount(); ++i) {
+                MotionDetectorConfig copy = current;
+                engine.configQueue(i).push(std::move(copy));
+            }
+            last_config = current;
+        }
+
+        if (popDisplayable(*display_sub, display) &&
+            renderOverlay(*display, overlay, roi_names)) {
+            cv::imshow("Motion Detector", overlay);
+        }
+
+        int key = cv::waitKey(1);
+        if (key == 'q') break;
+        if (key == 'n') {
+            engine.setDisplayRate(shown, 0.0);
+            shown = (shown + 1) % engine.streamCount();
+            engine.setDisplayRate(shown, opts.display_fps);
+            display_sub = engine.results(shown).subscribe();
+        }
+    }
+
+    display_sub.reset();
+    preview.stop();
+    engine.stop();
+    for (auto& recorder : recorders) recorder->stop();
+    for (auto& checkpointer : checkpointers) checkpointer->stop();
+    for (size_t i = 0; i < engine.streamCount(); ++i) {
+        logs[i]->stop();
+        std::cout << "Stream " << i << " (" << opts.sources[i]
+                  << ") logged to " << streamOutputPath(opts.output, i) << "\n";
+        printLogStats(*logs[i]);
+        printCaptureStats(engine.capture(i));
+        printQueueStats(engine.buffer(i), engine.consumer(i));
+        printMotionStats(engine.consumer(i), roi_names);
+        if (i < recorders.size()) printClipStats(*recorders[i]);
+        if (i < publishers.size()) printShmStats(*publishers[i]);
+        if (i < checkpointers.size()) printCheckpointStats(*checkpointers[i], engine.consumer(i));
+        if (i < governors.size()) printGovernorStats(*governors[i]);
+    }
+    if (opts.preview.port > 0) printPreviewStats(preview);
+    printFinalSettings();
+    return 0;
+}
+
 int main(int argc, char** argv) {
     std::signal(SIGINT, signalHandler);
     
-    std::string source = argc > 1 ? argv[1] : "0";
-    std::string output = argc > 2 ? argv[2] : "motion_data.csv";
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) {
+        printUsage(argv[0]);
+        return 1;
+    }
     
+    std::cout << "Detection kernel: " << fusedKernelPath() << "\n";
+    MetricsExporter metrics(opts.metrics);
+    if (metricsRequested(opts) && !metrics.start()) {
+#if !MOTION_METRICS
+        // The exporter reports its own errors when it is compiled in
+        std::cerr << "Metrics unavailable: built without MOTION_ENABLE_METRICS" << std::endl;
+#endif
+    }
+    if (opts.batch) {
+        return runBatch(opts);
+    }
     std::cout << "Motion Detector - Press Q to quit\n";
+    if (opts.multi) {
+        return runMultiStream(opts);
+    }
+    
+    const std::string& source = opts.sources.front();
+    EventLog::Options log_opts = opts.log;
+    log_opts.path = opts.output;
+    EventLog event_log(log_opts);
+    if (!event_log.start()) return 1;
     
     MotionDetectionConfigQueue config_queue;
-    MotionDetectionResultQueue result_queue;
+    MotionDetectionResultChannel results;
     
-    FrameQueue buffer(30);
-    VideoCapture capture(source, buffer);
-    MotionConsumer consumer(buffer, config_queue, result_queue);
+    auto buffer = FrameQueue::create(opts.queue);
+    VideoCapture capture(source, *buffer, opts.capture);
+    // Outlives the consumer, whose stop() writes the last checkpoint
+    BackgroundCheckpointer checkpointer(opts.checkpoint);
+    LoadGovernor governor(opts.governor);
+    MotionConsumer consumer(*buffer, config_queue, results);
+    consumer.setEventLog(&event_log);
+    std::unique_ptr<WorkerPool> strip_pool;
+    if (base_config.strips > 1) {
+        // The processing thread takes a strip itself
+        strip_pool = std::make_unique<WorkerPool>(base_config.strips - 1);
+        consumer.setWorkerPool(strip_pool.get());
+    }
+    std::unique_ptr<WorkerPool> clip_pool;
+    std::unique_ptr<ClipRecorder> recorder;
+    if (opts.record_clips) {
+        clip_pool = std::make_unique<WorkerPool>(kClipEncodeWorkers);
+        recorder = std::make_unique<ClipRecorder>(opts.clips, *clip_pool);
+        if (!recorder->start()) return 1;
+        consumer.setClipRecorder(recorder.get());
+    }
+    ShmFramePublisher::Options shm_opts;
+    shm_opts.name = opts.shm_name;
+    ShmFramePublisher publisher(shm_opts);
+    if (!opts.shm_name.empty()) consumer.setShmPublisher(&publisher);
+    if (!opts.checkpoint.path.empty()) {
+        checkpointer.start();
+        consumer.setCheckpointer(&checkpointer);
+    }
+    if (opts.govern) {
+        consumer.setLoadGovernor(&governor, &capture, [](const LoadGovernor::Transition& t) {
+            printGovernorTransition(0, t);
+        });
+    }
+    consumer.setEpisodeOptions(opts.episodes);
+    consumer.setEpisodeCallback([names = roiNames()](const MotionEpisode& e) {
+        printEpisode(0, e, names);
+    });
+    consumer.setDisplayRate(opts.headless ? 0.0 : opts.display_fps);
+    PreviewServer::Options preview_opts = opts.preview;
+    preview_opts.roi_names = roiNames();
+    PreviewServer preview(preview_opts);
+    preview.addStream(results, [&consumer](double fps) { consumer.setPreviewRate(fps); });
+    if (metricsRequested(opts)) {
+        capture.enableMetrics("stream=\"0\"");
+        consumer.enableMetrics("stream=\"0\"");
+    }
     
     if (!capture.start()) {
         std::cerr << "Failed to start capture" << std::endl;
@@ -53,54 +725,61 @@ int main(int argc, char** argv) {
     config_queue.push(buildConfig());
     
     consumer.start();
+    if (!startPreview(preview, opts)) {
+        consumer.stop();
+        capture.stop();
+        return 1;
+    }
     
-    cv::namedWindow("Motion Detector", cv::WINDOW_NORMAL);
-    cv::resizeWindow("Motion Detector", 1280, 720);
-    cv::moveWindow("Motion Detector", 100, 100);
-    
-    cv::createTrackbar("ROI X", "Motion Detector", &roi_center_x, 100);
-    cv::createTrackbar("ROI Y", "Motion Detector", &roi_center_y, 100);
-    cv::createTrackbar("ROI Width", "Motion Detector", &roi_width, 100);
-    cv::createTrackbar("ROI Height", "Motion Detector", &roi_height, 100);
-    cv::createTrackbar("Threshold", "Motion Detector", &threshold, 100);
-    cv::createTrackbar("Min Area", "Motion Detector", &min_contour_area, 300);
+    if (!opts.headless) setupWindow();
     
     MotionDetectorConfig last_config = buildConfig();
+    std::unique_ptr<ResultSubscriber> display_sub;
+    if (!opts.headless) display_sub = results.subscribe();
+    ResultPtr display;
+    cv::Mat overlay;
+    const std::vector<std::string> roi_names = roiNames();
     
     while (g_running) {
+        if (opts.headless) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
         // Check if config changed
         MotionDetectorConfig current = buildConfig();
-        if (current.roi.center_x != last_config.roi.center_x ||
-            current.roi.center_y != last_config.roi.center_y ||
-            current.roi.width_ratio != last_config.roi.width_ratio ||
-            current.roi.height_ratio != last_config.roi.height_ratio ||
-            current.threshold != last_config.threshold ||
-            current.min_contour_area != last_config.min_contour_area) {
-            
+        if (configChanged(current, last_config)) {
             config_queue.push(std::move(current));
             last_config = std::move(current);
         }
         
-        // Display latest result
-        if (auto result = result_queue.tryPopLatest()) {
-            cv::imshow("Motion Detector", result->visualization);
+        // Display latest result that carries a frame
+        if (popDisplayable(*display_sub, display) &&
+            renderOverlay(*display, overlay, roi_names)) {
+            cv::imshow("Motion Detector", overlay);
         }
         
         if (cv::waitKey(1) == 'q') break;
     }
     
+    preview.stop();
     consumer.stop();
     capture.stop();
-    consumer.exportCSV(output);
+    if (recorder) recorder->stop();
+    checkpointer.stop();
+    event_log.stop();
+    printLogStats(event_log);
+    printCaptureStats(capture);
+    printQueueStats(*buffer, consumer);
+    printMotionStats(consumer, roi_names);
+    if (recorder) printClipStats(*recorder);
+    if (!opts.shm_name.empty()) printShmStats(publisher);
+    if (!opts.checkpoint.path.empty()) printCheckpointStats(checkpointer, consumer);
+    if (opts.govern) printGovernorStats(governor);
+    if (opts.preview.port > 0) printPreviewStats(preview);
     
-    std::cout << "\n=== Final Settings ===\n";
-    std::cout << "roi.center_x = " << roi_center_x / 100.0f << "f;\n";
-    std::cout << "roi.center_y = " << roi_center_y / 100.0f << "f;\n";
-    std::cout << "roi.width_ratio = " << roi_width / 100.0f << "f;\n";
-    std::cout << "roi.height_ratio = " << roi_height / 100.0f << "f;\n";
-    std::cout << "threshold = " << threshold << ";\n";
-    std::cout << "min_contour_area = " << min_contour_area * 100 << ";\n";
+    printFinalSettings();
     
-    std::cout << "Data exported to " << output << std::endl;
+    std::cout << "Data logged to " << opts.output << std::endl;
     return 0;
 }
\ No newline at end of file
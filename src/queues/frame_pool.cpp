@@ -0,0 +1,57 @@
+#include "queues/frame_pool.hpp"
+#include <algorithm>
+
+FramePool::FramePool(size_t capacity) : capacity_(capacity) {
+    buffers_.reserve(capacity);
+}
+
+bool FramePool::isFree(const cv::Mat& m) {
+    // Acquire pairs with the release in cv::Mat::release() on other threads,
+    // so their last reads of the buffer happen before we hand it out again.
+    return m.u && __atomic_load_n(&m.u->refcount, __ATOMIC_ACQUIRE) == 1;
+}
+
+cv::Mat FramePool::acquire(cv::Size size, int type) {
+    if (size.width <= 0 || size.height <= 0) return cv::Mat();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < buffers_.size();) {
+        cv::Mat& candidate = buffers_[i];
+        if (!isFree(candidate)) {
+            ++i;
+        } else if (candidate.size() == size && candidate.type() == type) {
+            ++reuses_;
+            return candidate;
+        } else {
+            // Geometry changed (e.g. stream reconnect): drop the stale buffer
+            buffers_.erase(buffers_.begin() + i);
+        }
+    }
+
+    ++allocations_;
+    cv::Mat buffer(size, type);
+    if (buffers_.size() < capacity_) {
+        buffers_.push_back(buffer);
+    }
+    return buffer;
+}
+
+void FramePool::preallocate(cv::Size size, int type, size_t count) {
+    if (size.width <= 0 || size.height <= 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (buffers_.size() < std::min(count, capacity_)) {
+        ++allocations_;
+        buffers_.emplace_back(size, type);
+    }
+}
+
+void FramePool::addCapacity(size_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ += n;
+    buffers_.reserve(capacity_);
+}
+
+size_t FramePool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffers_.size();
+}
@@ -1,55 +1,29 @@
 #include "queues/frame_queue.hpp"
-#include <chrono>
+#include "queues/lockfree_frame_queue.hpp"
+#include "queues/mutex_frame_queue.hpp"
 
-FrameQueue::FrameQueue(size_t max_size) : max_size_(max_size) {}
-/** 
- * Push frame to buffer, blocking if queue is full
- * 
- * Waits until there's space (or shutdown), then pushes frame
- * and notifies any waiting pop() calls.
- * Returns false if shutdown during wait, true on success
-*/
-bool FrameQueue::push(TimestampedFrame&& frame) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_not_full_.wait(lock, [this] {
-      return queue_.size() < max_size_ || shutdown_;
-    });
-    if (shutdown_) return false;
-    queue_.push(std::move(frame));
-    cv_not_empty_.notify_one();
-    return true;
+std::unique_ptr<FrameQueue> FrameQueue::create(const Options& opts) {
+    if (opts.lock_free) {
+        return std::make_unique<LockFreeFrameQueue>(opts.max_size, opts.policy);
+    }
+    return std::make_unique<MutexFrameQueue>(opts.max_size, opts.policy);
 }
 
-/** 
- * Pop frame from buffer, blocking up to timeout if empty
- * 
- * Waits until there's data (or shutdown/timeout), then pops frame
- * and notifies any waiting push() calls.
- * Returns false if timeout/shutdown with no data, true on success
-*/
-bool FrameQueue::pop(TimestampedFrame& frame, int timeout_ms) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    bool has_data = cv_not_empty_.wait_for(
-        lock, std::chrono::milliseconds(timeout_ms),
-        [this] { return !queue_.empty() || shutdown_; }
-    );
-    if (!has_data || queue_.empty()) return false;
-    frame = std::move(queue_.front());
-    queue_.pop();
-    cv_not_full_.notify_one();
-    return true;
-}
+// Pool slack covers the frame being captured, processed and displayed
+FrameQueue::FrameQueue(size_t max_size, OverflowPolicy policy)
+    : max_size_(max_size), policy_(policy), pool_(max_size + 4) {}
 
-/** Shutdown the buffer, waking up all waiting threads */
-void FrameQueue::shutdown() {
-    shutdown_ = true;
-    cv_not_empty_.notify_all();
-    cv_not_full_.notify_all();
+FrameQueue::Stats FrameQueue::stats() const {
+    Stats s;
+    s.pushed = pushed_;
+    s.popped = popped_;
+    s.dropped_oldest = dropped_oldest_;
+    s.dropped_newest = dropped_newest_;
+    s.dropped_stale = dropped_stale_;
+    return s;
 }
 
-    
-size_t FrameQueue::size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return queue_.size();
+/** Set before the producer starts; not synchronized with push() */
+void FrameQueue::setPushListener(std::function<void()> listener) {
+    push_listener_ = std::move(listener);
 }
-
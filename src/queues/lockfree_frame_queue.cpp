@@ -0,0 +1,103 @@
+#include "queues/lockfree_frame_queue.hpp"
+#include <chrono>
+#include <thread>
+
+namespace {
+// Spin, then yield, then sleep: cheap when the other side is about to
+// catch up, without burning a core while a source is idle.
+void backoff(int& attempt) {
+    if (attempt < 64) {
+        ++attempt;
+    } else if (attempt < 128) {
+        ++attempt;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+}
+
+LockFreeFrameQueue::LockFreeFrameQueue(size_t max_size, OverflowPolicy policy)
+    : FrameQueue(max_size, policy), ring_(max_size) {
+    max_size_ = ring_.capacity();
+}
+
+bool LockFreeFrameQueue::push(TimestampedFrame&& frame) {
+    int attempt = 0;
+    while (!ring_.tryPush(std::move(frame))) {
+        if (shutdown_) return false;
+        switch (policy_) {
+            case OverflowPolicy::BLOCK:
+                backoff(attempt);
+                break;
+            case OverflowPolicy::DROP_NEWEST:
+                ++dropped_newest_;
+                return false;
+            case OverflowPolicy::DROP_OLDEST:
+            case OverflowPolicy::LATEST_ONLY: {
+                TimestampedFrame evicted;
+                if (ring_.tryPop(evicted)) ++dropped_oldest_;
+                break;
+            }
+        }
+    }
+    ++pushed_;
+    notifyPushed();
+    return true;
+}
+
+bool LockFreeFrameQueue::pop(TimestampedFrame& frame, int timeout_ms) {
+    if (popNow(frame)) return true;
+    if (timeout_ms <= 0) return false;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    int attempt = 0;
+    while (!shutdown_ && std::chrono::steady_clock::now() < deadline) {
+        backoff(attempt);
+        if (popNow(frame)) return true;
+    }
+    // Drain what is left after shutdown, like the mutex queue does
+    return popNow(frame);
+}
+
+bool LockFreeFrameQueue::popNow(TimestampedFrame& frame) {
+    if (policy_ == OverflowPolicy::LATEST_ONLY) return popLatest(frame);
+    if (!ring_.tryPop(frame)) return false;
+    ++popped_;
+    return true;
+}
+
+bool LockFreeFrameQueue::popLatest(TimestampedFrame& frame) {
+    if (!ring_.tryPop(frame)) return false;
+    TimestampedFrame newer;
+    while (ring_.tryPop(newer)) {
+        frame = std::move(newer);
+        ++dropped_stale_;
+    }
+    ++popped_;
+    return true;
+}
+
+void LockFreeFrameQueue::shutdown() {
+    shutdown_ = true;
+}
+
+size_t LockFreeFrameQueue::size() const {
+    return ring_.size();
+}
+
+std::optional<TimestampedFrame> LockFreeFrameQueue::tryPop() {
+    TimestampedFrame frame;
+    if (!pop(frame, 0)) return std::nullopt;
+    return frame;
+}
+
+std::optional<TimestampedFrame> LockFreeFrameQueue::tryPopLatest() {
+    TimestampedFrame frame;
+    if (!popLatest(frame)) return std::nullopt;
+    return frame;
+}
+
+bool LockFreeFrameQueue::empty() const {
+    return ring_.size() == 0;
+}
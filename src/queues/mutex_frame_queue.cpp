@@ -0,0 +1,101 @@
+#include "queues/mutex_frame_queue.hpp"
+#include <chrono>
+
+MutexFrameQueue::MutexFrameQueue(size_t max_size, OverflowPolicy policy)
+    : FrameQueue(max_size, policy) {}
+
+/** 
+ * Push frame to buffer, applying the overflow policy if queue is full
+ * 
+ * BLOCK waits until there's space (or shutdown); the drop policies never
+ * wait. Notifies any waiting pop() calls.
+ * Returns false if shutdown during wait or the frame was dropped
+*/
+bool MutexFrameQueue::push(TimestampedFrame&& frame) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (policy_ == OverflowPolicy::BLOCK) {
+            cv_not_full_.wait(lock, [this] {
+              return queue_.size() < max_size_ || shutdown_;
+            });
+        }
+        if (shutdown_) return false;
+        if (queue_.size() >= max_size_) {
+            if (policy_ == OverflowPolicy::DROP_NEWEST) {
+                ++dropped_newest_;
+                return false;
+            }
+            queue_.pop();
+            ++dropped_oldest_;
+        }
+        queue_.push(std::move(frame));
+        ++pushed_;
+        cv_not_empty_.notify_one();
+    }
+    notifyPushed();
+    return true;
+}
+
+/** 
+ * Pop frame from buffer, blocking up to timeout if empty
+ * 
+ * Waits until there's data (or shutdown/timeout), then pops frame
+ * (the newest one under LATEST_ONLY) and notifies any waiting push() calls.
+ * Returns false if timeout/shutdown with no data, true on success
+*/
+bool MutexFrameQueue::pop(TimestampedFrame& frame, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool has_data = cv_not_empty_.wait_for(
+        lock, std::chrono::milliseconds(timeout_ms),
+        [this] { return !queue_.empty() || shutdown_; }
+    );
+    if (!has_data || queue_.empty()) return false;
+    popLocked(frame, policy_ == OverflowPolicy::LATEST_ONLY);
+    return true;
+}
+
+void MutexFrameQueue::popLocked(TimestampedFrame& frame, bool latest) {
+    if (latest) {
+        dropped_stale_ += queue_.size() - 1;
+        frame = std::move(queue_.back());
+        queue_ = {};
+    } else {
+        frame = std::move(queue_.front());
+        queue_.pop();
+    }
+    ++popped_;
+    cv_not_full_.notify_one();
+}
+
+/** Shutdown the buffer, waking up all waiting threads */
+void MutexFrameQueue::shutdown() {
+    shutdown_ = true;
+    cv_not_empty_.notify_all();
+    cv_not_full_.notify_all();
+}
+
+size_t MutexFrameQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+std::optional<TimestampedFrame> MutexFrameQueue::tryPop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) return std::nullopt;
+    TimestampedFrame frame;
+    popLocked(frame, policy_ == OverflowPolicy::LATEST_ONLY);
+    return frame;
+}
+
+std::optional<TimestampedFrame> MutexFrameQueue::tryPopLatest() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) return std::nullopt;
+    TimestampedFrame frame;
+    popLocked(frame, true);
+    return frame;
+}
+
+bool MutexFrameQueue::empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.empty();
+}
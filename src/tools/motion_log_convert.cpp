@@ -0,0 +1,88 @@
+#include "core/motion_log.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Converts motion logs between CSV and the binary .mdlog format.
+// The direction is picked from the input extension.
+
+namespace {
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int csvToBinary(const std::string& in, const std::string& out) {
+    std::ifstream file(in);
+    if (!file) {
+        std::cerr << "Cannot open " << in << std::endl;
+        return 1;
+    }
+
+    std::string line;
+    if (!std::getline(file, line)) {
+        std::cerr << "Empty CSV: " << in << std::endl;
+        return 1;
+    }
+    std::vector<std::string> columns = parseMotionCsvHeader(line);
+
+    // Count rows first: the binary layout reserves the full column size
+    uint64_t rows = 0;
+    while (std::getline(file, line)) {
+        if (!line.empty()) ++rows;
+    }
+    file.clear();
+    file.seekg(0);
+    std::getline(file, line);
+
+    MotionLogWriter writer;
+    if (!writer.open(out, rows)) {
+        std::cerr << "Cannot create " << out << std::endl;
+        return 1;
+    }
+    MotionEvent e;
+    while (std::getline(file, line)) {
+        if (line.empty() || !parseMotionCsvRow(line, columns, e)) continue;
+        writer.append(e);
+    }
+    writer.close();
+    std::cout << "Wrote " << rows << " rows to " << out << std::endl;
+    return 0;
+}
+
+int binaryToCsv(const std::string& in, const std::string& out) {
+    MotionLogReader reader;
+    if (!reader.open(in)) {
+        std::cerr << "Not a valid motion log: " << in << std::endl;
+        return 1;
+    }
+    std::ofstream file(out);
+    if (!file) {
+        std::cerr << "Cannot create " << out << std::endl;
+        return 1;
+    }
+
+    file << kMotionCsvHeader;
+    char line[256];
+    uint64_t rows = reader.count();
+    for (uint64_t i = 0; i < rows; ++i) {
+        int n = formatMotionCsvRow(reader.event(i), line, sizeof(line));
+        file.write(line, n);
+    }
+    std::cout << "Wrote " << rows << " rows to " << out << std::endl;
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <in.csv> <out.mdlog>\n"
+                  << "       " << argv[0] << " <in.mdlog> <out.csv>\n";
+        return 1;
+    }
+    std::string in = argv[1];
+    std::string out = argv[2];
+    return endsWith(in, ".mdlog") ? binaryToCsv(in, out) : csvToBinary(in, out);
+}
@@ -0,0 +1,111 @@
+#include "core/shm_frame_reader.hpp"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Test reader for a shared-memory frame ring (motion_detector --shm NAME).
+// Follows the frames in order, or only the newest with --latest, and
+// prints one line per second: rate, mask coverage, skipped and torn
+// frames, and the newest events. The mask is scanned in place, so this
+// also shows the cost of reading straight from the mapping.
+
+namespace {
+
+volatile std::sig_atomic_t g_running = 1;
+void onSignal(int) { g_running = 0; }
+
+using Clock = std::chrono::steady_clock;
+
+void printSecond(const ShmFrame& f, double fps, double coverage, uint64_t skipped,
+                 uint64_t torn) {
+    char line[512];
+    int n = std::snprintf(line, sizeof(line),
+                          "frame %llu  %.1f fps  %dx%d  mask %.2f%%  skipped %llu  torn %llu",
+                          static_cast<unsigned long long>(f.frame_id), fps, f.frame.cols,
+                          f.frame.rows, coverage * 100.0,
+                          static_cast<unsigned long long>(skipped),
+                          static_cast<unsigned long long>(torn));
+    for (const MotionEvent& e : f.events) {
+        if (n >= static_cast<int>(sizeof(line))) break;
+        n += std::snprintf(line + n, sizeof(line) - n, "  roi%d %.3f/%d", e.roi_index,
+                           e.motion_score, e.contour_count);
+    }
+    std::puts(line);
+    std::fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string name;
+    bool latest = false;
+    uint64_t limit = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--latest") {
+            latest = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            limit = std::stoull(argv[++i]);
+        } else if (name.empty() && arg[0] != '-') {
+            name = arg[0] == '/' ? arg : "/" + arg;
+        } else {
+            name.clear();
+            break;
+        }
+    }
+    if (name.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <shm name> [--latest] [--frames N]\n";
+        return 1;
+    }
+    std::signal(SIGINT, onSignal);
+
+    ShmFrameReader reader;
+    bool waiting = false;
+    while (g_running && !reader.open(name)) {
+        if (!waiting) std::cout << "Waiting for " << name << "...\n";
+        waiting = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    if (!reader.isOpen()) return 1;
+    std::cout << "Attached to " << name << " (" << reader.header().slot_count << " slots, "
+              << reader.header().total_size / (1024 * 1024) << " MB)\n";
+
+    ShmFrame frame, shown;
+    uint64_t frames = 0, second_frames = 0, torn = 0, last_index = UINT64_MAX;
+    double coverage = 0.0;
+    auto second_start = Clock::now();
+    while (g_running && (limit == 0 || frames < limit)) {
+        // Checked first: once closed, nothing is published after it
+        const bool closed = reader.closed();
+        bool got = latest ? reader.latest(frame) && frame.index != last_index
+                          : reader.next(frame);
+        if (!got) {
+            if (closed) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        int motion = frame.mask.empty() ? 0 : cv::countNonZero(frame.mask);
+        if (!reader.valid(frame)) {
+            ++torn;  // rewritten while we scanned it
+            continue;
+        }
+        last_index = frame.index;
+        coverage = frame.mask.empty() ? 0.0 : static_cast<double>(motion) / frame.mask.total();
+        shown = frame;
+        ++frames;
+        ++second_frames;
+
+        double elapsed = std::chrono::duration<double>(Clock::now() - second_start).count();
+        if (elapsed >= 1.0) {
+            printSecond(shown, second_frames / elapsed, coverage, reader.skipped(), torn);
+            second_frames = 0;
+            second_start = Clock::now();
+        }
+    }
+    std::cout << "Read " << frames << " frames, skipped " << reader.skipped()
+              << ", torn " << torn << (reader.closed() ? " (publisher closed)" : "") << "\n";
+    return 0;
+}